@@ -124,6 +124,10 @@ The following things can be found, at a glance, in the different modules:
 * `common <{WEBSITE_URL}/modules/common/common.html>`_:
   Miscellaneous, but useful, things that do not fit anywhere else.
 
+* `dma_axi_read_simple <{WEBSITE_URL}/modules/dma_axi_read_simple/dma_axi_read_simple.html>`_:
+  Very efficient IP for streaming data from DDR to FPGA over AXI.
+  Complete with a zero-copy C++ producer driver.
+
 * `dma_axi_write_simple <{WEBSITE_URL}/modules/dma_axi_write_simple/dma_axi_write_simple.html>`_:
   The world's most efficient IP for streaming data from FPGA to DDR over AXI.
   Complete with a full C++ driver.
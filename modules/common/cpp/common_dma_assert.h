@@ -0,0 +1,67 @@
+// -------------------------------------------------------------------------------------------------
+// Copyright (c) Lukas Vik. All rights reserved.
+//
+// This file is part of the hdl-modules project, a collection of reusable, high-quality,
+// peer-reviewed VHDL building blocks.
+// https://hdl-modules.com
+// https://github.com/hdl-modules/hdl-modules
+// -------------------------------------------------------------------------------------------------
+
+// Error checking macros shared by the C++ drivers of the DMA modules,
+// 'dma_axi_write_simple' and 'dma_axi_read_simple'.
+// Private to the implementation, and not part of any public 'include' folder.
+// Requires the class to have the members 'm_assertion_handler' and
+// 'm_error_handler', and to be in the namespace where the module's 'Error' and
+// 'ErrorCode' are declared.
+
+#pragma once
+
+#ifndef NO_DMA_ASSERT_MESSAGE
+#include <sstream>
+#include <string>
+#endif
+
+#ifdef NO_DMA_ASSERT
+
+#define _DMA_ASSERT_TRUE(expression, error_code, interrupt_status, value,      \
+                         message)                                              \
+  ((void)0)
+
+#else // Not NO_DMA_ASSERT.
+
+#ifdef NO_DMA_ASSERT_MESSAGE
+
+// Errors are reported only to the error handler, and no message is formatted.
+#define _DMA_REPORT_MESSAGE(message) ((void)0)
+
+#else // Not NO_DMA_ASSERT_MESSAGE.
+
+#define _DMA_REPORT_MESSAGE(message)                                           \
+  {                                                                            \
+    std::ostringstream diagnostics;                                            \
+    diagnostics << "DMA error occurred in " << __FILE__ << ":" << __LINE__     \
+                << ", message: " << message << ".";                            \
+    std::string diagnostic_message = diagnostics.str();                        \
+    m_assertion_handler(&diagnostic_message);                                  \
+  }
+
+#endif // NO_DMA_ASSERT_MESSAGE.
+
+// This macro is called by the DMA code to check for runtime errors.
+// The message is only formatted if there is no error handler set.
+#define _DMA_ASSERT_TRUE(expression, error_code, interrupt_status, value,      \
+                         message)                                              \
+  {                                                                            \
+    if (!static_cast<bool>(expression)) {                                      \
+      if (m_error_handler != nullptr) {                                        \
+        const Error error = {ErrorCode::error_code, __FILE__, __LINE__,        \
+                             static_cast<uint32_t>(interrupt_status),          \
+                             static_cast<uint64_t>(value)};                    \
+        m_error_handler(&error);                                               \
+      } else {                                                                 \
+        _DMA_REPORT_MESSAGE(message);                                          \
+      }                                                                        \
+    }                                                                          \
+  }
+
+#endif // NO_DMA_ASSERT.
@@ -0,0 +1,221 @@
+// -------------------------------------------------------------------------------------------------
+// Copyright (c) Lukas Vik. All rights reserved.
+//
+// This file is part of the hdl-modules project, a collection of reusable, high-quality,
+// peer-reviewed VHDL building blocks.
+// https://hdl-modules.com
+// https://github.com/hdl-modules/hdl-modules
+// -------------------------------------------------------------------------------------------------
+
+#include "include/dma_axi_read_simple_producer.h"
+
+#include "../../common/cpp/common_dma_assert.h"
+
+namespace fpga {
+
+namespace dma_axi_read_simple {
+
+DmaProducer::DmaProducer(uintptr_t register_base_address, void *buffer,
+                         size_t buffer_size_bytes, size_t packet_length_bytes,
+                         bool (*assertion_handler)(const std::string *))
+    : DmaProducer(register_base_address, reinterpret_cast<uintptr_t>(buffer),
+                  buffer, buffer_size_bytes, packet_length_bytes,
+                  assertion_handler) {}
+
+DmaProducer::DmaProducer(uintptr_t register_base_address,
+                         uint64_t buffer_physical_address, void *buffer,
+                         size_t buffer_size_bytes, size_t packet_length_bytes,
+                         bool (*assertion_handler)(const std::string *))
+    : m_buffer(reinterpret_cast<volatile uint8_t *>(buffer)),
+      m_buffer_size_bytes(buffer_size_bytes),
+      m_packet_length_bytes(packet_length_bytes),
+      m_assertion_handler(assertion_handler),
+      m_start_address(buffer_physical_address),
+      m_end_address(buffer_physical_address + buffer_size_bytes),
+      registers(fpga_regs::DmaAxiReadSimple(register_base_address,
+                                              assertion_handler)) {
+  // One packet is always left unused, so at least two are needed.
+  _DMA_ASSERT_TRUE(packet_length_bytes > 0 &&
+                       buffer_size_bytes % packet_length_bytes == 0 &&
+                       buffer_size_bytes >= 2 * packet_length_bytes,
+                   invalid_buffer_size, 0, buffer_size_bytes,
+                   "Buffer size " << buffer_size_bytes
+                                  << " is not a multiple of, and at least two "
+                                     "times, the packet length "
+                                  << packet_length_bytes);
+
+  // All address calculations in this class are done on the lower 32 bits.
+  // The upper bits are only written once, when setting up the module.
+  _DMA_ASSERT_TRUE((m_start_address >> 32) == ((m_end_address - 1) >> 32),
+                   buffer_crosses_address_boundary, 0, m_start_address,
+                   "Buffer must not cross a 4 GiB address boundary");
+}
+
+void DmaProducer::set_error_handler(bool (*error_handler)(const Error *)) {
+  m_error_handler = error_handler;
+}
+
+void DmaProducer::setup_and_enable() {
+  _DMA_ASSERT_TRUE(!registers.get_config_enable(), already_enabled, 0, 0,
+                   "Tried to enable DMA that is already running");
+
+  registers.set_buffer_start_address_high(
+      static_cast<uint32_t>(m_start_address >> 32));
+  registers.set_buffer_end_address_high(
+      static_cast<uint32_t>(m_end_address >> 32));
+  registers.set_buffer_written_address_high(
+      static_cast<uint32_t>(m_start_address >> 32));
+
+  registers.set_buffer_start_address(static_cast<uint32_t>(m_start_address));
+  registers.set_buffer_end_address(static_cast<uint32_t>(m_end_address));
+  registers.set_buffer_written_address(static_cast<uint32_t>(m_start_address));
+
+  m_in_buffer_acquired_address = 0;
+  m_in_buffer_committed_address = 0;
+  m_in_buffer_read_address = 0;
+
+  registers.set_config_enable(1);
+}
+
+Span DmaProducer::acquire_space(size_t min_num_bytes, size_t max_num_bytes) {
+  check_status();
+
+  size_t num_bytes_free = get_num_bytes_free_cached();
+  if (num_bytes_free < min_num_bytes) {
+    // Our local copy of the read address is probably outdated.
+    update_read_address();
+    num_bytes_free = get_num_bytes_free_cached();
+
+    if (num_bytes_free < min_num_bytes) {
+      return span_zero_bytes;
+    }
+  }
+
+  // Acquire at most up until the end, since the result must be contiguous.
+  const size_t num_bytes_until_end =
+      m_buffer_size_bytes - m_in_buffer_acquired_address;
+  const size_t result_num_bytes =
+      std::min(std::min(num_bytes_free, max_num_bytes), num_bytes_until_end);
+
+  if (result_num_bytes == 0) {
+    return span_zero_bytes;
+  }
+
+  volatile void *result_data = &m_buffer[m_in_buffer_acquired_address];
+
+  m_in_buffer_acquired_address = static_cast<uint32_t>(
+      (m_in_buffer_acquired_address + result_num_bytes) % m_buffer_size_bytes);
+
+  return {result_num_bytes, result_data};
+}
+
+void DmaProducer::commit(size_t num_bytes) {
+  _DMA_ASSERT_TRUE(num_bytes % m_packet_length_bytes == 0, invalid_commit, 0,
+                   num_bytes,
+                   "Commit must be a multiple of the packet length: "
+                       << num_bytes);
+  _DMA_ASSERT_TRUE(num_bytes <= get_distance(m_in_buffer_committed_address,
+                                             m_in_buffer_acquired_address),
+                   invalid_commit, 0, num_bytes,
+                   "Can not commit more than has been acquired: "
+                       << num_bytes);
+
+  if (num_bytes == 0) {
+    return;
+  }
+
+  if (m_cache_flush_function != nullptr) {
+    // The committed data might wrap around the end of the buffer.
+    const size_t num_bytes_until_end =
+        m_buffer_size_bytes - m_in_buffer_committed_address;
+    const size_t num_bytes_first = std::min(num_bytes, num_bytes_until_end);
+
+    m_cache_flush_function(
+        const_cast<const uint8_t *>(&m_buffer[m_in_buffer_committed_address]),
+        num_bytes_first);
+    if (num_bytes_first < num_bytes) {
+      m_cache_flush_function(const_cast<const uint8_t *>(&m_buffer[0]),
+                             num_bytes - num_bytes_first);
+    }
+  }
+
+  m_in_buffer_committed_address = static_cast<uint32_t>(
+      (m_in_buffer_committed_address + num_bytes) % m_buffer_size_bytes);
+  registers.set_buffer_written_address(static_cast<uint32_t>(m_start_address) +
+                                       m_in_buffer_committed_address);
+}
+
+void DmaProducer::set_cache_flush_function(void (*flush_function)(const void *,
+                                                                  size_t)) {
+  m_cache_flush_function = flush_function;
+}
+
+size_t DmaProducer::get_num_bytes_free() {
+  update_read_address();
+
+  return get_num_bytes_free_cached();
+}
+
+size_t DmaProducer::get_num_bytes_pending() {
+  update_read_address();
+
+  return get_distance(m_in_buffer_read_address, m_in_buffer_committed_address);
+}
+
+void DmaProducer::update_read_address() {
+  m_in_buffer_read_address = registers.get_buffer_read_address() -
+                             static_cast<uint32_t>(m_start_address);
+}
+
+size_t DmaProducer::get_distance(uint32_t from_address,
+                                 uint32_t to_address) const {
+  if (to_address >= from_address) {
+    return to_address - from_address;
+  }
+
+  return to_address + m_buffer_size_bytes - from_address;
+}
+
+size_t DmaProducer::get_num_bytes_free_cached() const {
+  // Everything that has been acquired, committed or not, is in use.
+  const size_t num_bytes_used =
+      get_distance(m_in_buffer_read_address, m_in_buffer_acquired_address);
+
+  // One packet of the buffer is always left unused.
+  // Checked so that an invalid buffer size, that has been reported by the
+  // constructor, does not wrap around to a huge number.
+  if (num_bytes_used + m_packet_length_bytes >= m_buffer_size_bytes) {
+    return 0;
+  }
+
+  return m_buffer_size_bytes - m_packet_length_bytes - num_bytes_used;
+}
+
+bool DmaProducer::check_status() {
+  const uint32_t register_value = registers.get_interrupt_status();
+  if (register_value) {
+    // Read and then clear status ASAP.
+    registers.set_interrupt_status(register_value);
+
+    _DMA_ASSERT_TRUE(
+        !registers.get_interrupt_status_read_error_from_value(register_value) &&
+            !registers
+                 .get_interrupt_status_start_address_unaligned_error_from_value(
+                     register_value) &&
+            !registers
+                 .get_interrupt_status_end_address_unaligned_error_from_value(
+                     register_value) &&
+            !registers
+                 .get_interrupt_status_written_address_unaligned_error_from_value(
+                     register_value),
+        error_interrupt, register_value, 0,
+        "Got error interrupt from the FPGA AXI DMA read module: "
+            << register_value);
+  }
+
+  return registers.get_interrupt_status_read_done_from_value(register_value);
+}
+
+} // namespace dma_axi_read_simple
+
+} // namespace fpga
@@ -0,0 +1,268 @@
+// -------------------------------------------------------------------------------------------------
+// Copyright (c) Lukas Vik. All rights reserved.
+//
+// This file is part of the hdl-modules project, a collection of reusable, high-quality,
+// peer-reviewed VHDL building blocks.
+// https://hdl-modules.com
+// https://github.com/hdl-modules/hdl-modules
+// -------------------------------------------------------------------------------------------------
+
+#pragma once
+
+// Register interface class generated by hdl-registers.
+#include "dma_axi_read_simple.h"
+
+namespace fpga {
+
+namespace dma_axi_read_simple {
+
+struct Span {
+  size_t num_bytes;
+  volatile void *data;
+};
+
+// The different errors that can be detected by DmaProducer.
+enum class ErrorCode : uint32_t {
+  // The FPGA module has raised one of its error interrupts.
+  // See 'interrupt_status' of the Error for which one.
+  error_interrupt,
+  buffer_crosses_address_boundary,
+  already_enabled,
+  // See 'value' of the Error for the number of bytes.
+  invalid_commit,
+  // The buffer size is not a multiple of the packet length, or less than two
+  // packets.
+  // See 'value' of the Error for the buffer size.
+  invalid_buffer_size,
+};
+
+// Error record passed to the error handler, see DmaProducer::set_error_handler.
+// Fixed size, and does not own any memory.
+struct Error {
+  ErrorCode code;
+  // Source location of the check that failed.
+  const char *file;
+  uint32_t line;
+  // Raw value of the 'interrupt_status' register, for the 'error_interrupt'
+  // code.
+  // Otherwise zero.
+  uint32_t interrupt_status;
+  // The offending argument value, where applicable.
+  // Otherwise zero.
+  uint64_t value;
+};
+
+/**
+ * Class with simple API for using the simple AXI DMA read FPGA module.
+ * This is the producer counterpart of the 'DmaNoCopy' class of the
+ * 'dma_axi_write_simple' module.
+ * The user writes data directly into the memory buffer, without any copying
+ * in this class.
+ * See the methods DmaProducer::acquire_space and DmaProducer::commit for
+ * details.
+ */
+class DmaProducer {
+
+private:
+  volatile uint8_t *m_buffer;
+  size_t m_buffer_size_bytes;
+  size_t m_packet_length_bytes;
+
+  bool (*m_assertion_handler)(const std::string *);
+  bool (*m_error_handler)(const Error *) = nullptr;
+
+  // Physical addresses, as seen by the FPGA.
+  uint64_t m_start_address;
+  uint64_t m_end_address;
+
+  // Expressed as offsets from the start of the buffer.
+  // The end of the space that has been acquired by the user.
+  uint32_t m_in_buffer_acquired_address = 0;
+  // The value that has been written to the 'buffer_written_address' register.
+  uint32_t m_in_buffer_committed_address = 0;
+  // Local copy of the 'buffer_read_address' register.
+  uint32_t m_in_buffer_read_address = 0;
+
+  void (*m_cache_flush_function)(const void *, size_t) = nullptr;
+
+  /**
+   * Returns 'true' if the 'read_done' interrupt has triggered.
+   * Will call an assertion if any of the error interrupts have triggered.
+   */
+  bool check_status();
+
+  /**
+   * Read the 'buffer_read_address' register and update our local copy.
+   */
+  void update_read_address();
+
+  /**
+   * Return the number of bytes from 'from_address' to 'to_address', taking
+   * wrap-around into account.
+   */
+  size_t get_distance(uint32_t from_address, uint32_t to_address) const;
+
+  /**
+   * Return the number of bytes that can be acquired, given our local copy of
+   * the read address.
+   * Does not perform any register access.
+   */
+  size_t get_num_bytes_free_cached() const;
+
+  // Empty struct initialization -> all fields zero'd out.
+  // (most importantly, the 'num_bytes' value).
+  const Span span_zero_bytes = {};
+
+public:
+  /**
+   * Class constructor.
+   * @param register_base_address Byte address where the registers of the
+   *                              'dma_axi_read_simple' module are memory
+   *                              mapped.
+   *                              When using an operating system, care must be
+   *                              taken to pass the virtual address, not the
+   *                              physical address.
+   * @param buffer Pointer to memory buffer.
+   *               Must be allocated by user.
+   *               The address must be aligned with the packet length used by
+   *               the FPGA.
+   *               Will not be deleted by this class in any destructor, etc.
+   *
+   *               Note that this constructor will use this buffer for both the
+   *               physical and virtual memory address.
+   *               Meaning this constructor is only suitable for bare
+   *               metal applications.
+   * @param buffer_size_bytes The number of bytes in the memory buffer.
+   *                          Must be a multiple of the packet length used by
+   *                          the FPGA, and at least two packets.
+   * @param packet_length_bytes The packet length used by the FPGA, i.e. the
+   *                            'packet_length_beats' generic times the data
+   *                            width in bytes.
+   * @param assertion_handler Function to call when an assertion fails in
+   *                          this class.
+   *                          Function takes a string pointer as an argument and
+   *                          must return a boolean 'true'.
+   *                          Is not used for errors in this class if an error
+   *                          handler has been set, see
+   *                          DmaProducer::set_error_handler.
+   */
+  DmaProducer(uintptr_t register_base_address, void *buffer,
+              size_t buffer_size_bytes, size_t packet_length_bytes,
+              bool (*assertion_handler)(const std::string *));
+
+  /**
+   * Class constructor for use with an operating system, where the physical
+   * address of the memory buffer, as seen by the FPGA, is different from the
+   * virtual address used by the software.
+   *
+   * @param register_base_address See the other constructor.
+   * @param buffer_physical_address The physical address of the memory buffer.
+   *                                This is the value that will be written to
+   *                                the 'buffer_start_address' registers.
+   *                                The buffer must not cross a 4 GiB address
+   *                                boundary.
+   * @param buffer Virtual address of the same memory buffer.
+   * @param buffer_size_bytes See the other constructor.
+   * @param packet_length_bytes See the other constructor.
+   * @param assertion_handler See the other constructor.
+   */
+  DmaProducer(uintptr_t register_base_address, uint64_t buffer_physical_address,
+              void *buffer, size_t buffer_size_bytes,
+              size_t packet_length_bytes,
+              bool (*assertion_handler)(const std::string *));
+
+  /**
+   * Set a function to call when an error is detected in this class, instead
+   * of the assertion handler given to the constructor.
+   * Works like 'DmaNoCopy::set_error_handler' of the 'dma_axi_write_simple'
+   * module.
+   */
+  void set_error_handler(bool (*error_handler)(const Error *));
+
+  /**
+   * Write the necessary registers to setup the DMA module for operation, and
+   * then enable it.
+   * When this is done, data committed with DmaProducer::commit will be read
+   * by the FPGA.
+   */
+  void setup_and_enable();
+
+  /**
+   * Acquire space in the memory buffer that can be written with data.
+   *
+   * Like 'DmaNoCopy::receive_data' of the 'dma_axi_write_simple' module,
+   * the result is always contiguous in memory.
+   * If the free space wraps around the end of the buffer, the result will
+   * contain only the part until the end, which might be fewer bytes than
+   * 'min_num_bytes'.
+   * The rest can be acquired with another call.
+   *
+   * The same space will not be returned again until it has been committed
+   * with DmaProducer::commit and then read by the FPGA.
+   *
+   * Note that one packet of the buffer is always left unused, since a full
+   * buffer would be indistinguishable from an empty one.
+   *
+   * @param min_num_bytes Return zero bytes if there is less than this number
+   *                      of bytes free in the buffer.
+   * @param max_num_bytes Return at most this number of bytes.
+   * @return The number of bytes, and a pointer to where they shall be written.
+   *         Zero bytes if there was not enough space.
+   */
+  Span acquire_space(size_t min_num_bytes, size_t max_num_bytes);
+
+  /**
+   * Hand over data, that has been written to space previously acquired with
+   * DmaProducer::acquire_space, to the FPGA.
+   * Will update the 'buffer_written_address' register.
+   *
+   * Space is committed in the order it was acquired.
+   * Do not call this method with an argument that is greater than the number
+   * of bytes that has been acquired but not yet committed.
+   *
+   * @param num_bytes Must be a multiple of the packet length, since the FPGA
+   *                  reads whole packets.
+   */
+  void commit(size_t num_bytes);
+
+  /**
+   * Set a function that will be called on the committed data, before it is
+   * handed over to the FPGA.
+   * Use this when the memory buffer is cacheable and not coherent with the
+   * FPGA AXI port, so that the data written by the CPU is flushed from the
+   * cache to memory.
+   *
+   * @param flush_function Function that takes a pointer to the data and the
+   *                       number of bytes.
+   *                       Set to 'nullptr' to disable, which is the default.
+   */
+  void set_cache_flush_function(void (*flush_function)(const void *, size_t));
+
+  /**
+   * Return the number of bytes that are free in the memory buffer.
+   * Meaning, the number of bytes that can be acquired with
+   * DmaProducer::acquire_space, if wrap-around is not taken into account.
+   * Will read the 'buffer_read_address' register.
+   */
+  size_t get_num_bytes_free();
+
+  /**
+   * Return the number of bytes that have been committed but not yet read by
+   * the FPGA.
+   * Will read the 'buffer_read_address' register.
+   */
+  size_t get_num_bytes_pending();
+
+  /**
+   * Interface to access the registers of the FPGA module.
+   *
+   * Can be used to e.g. enable the interrupts that you want.
+   * Other than that, you are encouraged to use the API in this class
+   * rather than accessing the registers directly.
+   */
+  fpga_regs::DmaAxiReadSimple registers;
+};
+
+} // namespace dma_axi_read_simple
+
+} // namespace fpga
@@ -0,0 +1,100 @@
+# --------------------------------------------------------------------------------------------------
+# Copyright (c) Lukas Vik. All rights reserved.
+#
+# This file is part of the hdl-modules project, a collection of reusable, high-quality,
+# peer-reviewed VHDL building blocks.
+# https://hdl-modules.com
+# https://github.com/hdl-modules/hdl-modules
+# --------------------------------------------------------------------------------------------------
+
+from __future__ import annotations
+
+from typing import TYPE_CHECKING, Any
+
+from tsfpga.examples.vivado.project import TsfpgaExampleVivadoNetlistProject
+from tsfpga.module import BaseModule
+from tsfpga.vivado.build_result_checker import Ffs, LessThan, MaximumLogicLevel, TotalLuts
+
+if TYPE_CHECKING:
+    from vunit.ui import VUnit
+
+
+class Module(BaseModule):
+    def setup_vunit(
+        self,
+        vunit_proj: VUnit,
+        **kwargs: Any,  # noqa: ANN401, ARG002
+    ) -> None:
+        test = vunit_proj.library(self.library_name).test_bench("tb_dma_axi_read_simple")
+        for _ in range(8):
+            self.add_vunit_config(test=test, set_random_seed=True)
+
+    def get_build_projects(self) -> list[TsfpgaExampleVivadoNetlistProject]:
+        # The 'hdl_modules' Python package is probably not on the PYTHONPATH in most scenarios where
+        # this module is used. Hence we can not import at the top of this file.
+        # This method is only called when running netlist builds in the hdl-modules repo from the
+        # bundled tools/build_fpga.py, where PYTHONPATH is correctly set up.
+        from hdl_modules import get_hdl_modules
+
+        modules = get_hdl_modules()
+        part = "xc7z020clg400-1"
+
+        projects = []
+
+        # These are upper bounds, estimated from the corresponding 'dma_axi_write_simple' builds,
+        # with some margin.
+        # They shall be tightened to exact values, like the 'dma_axi_write_simple' builds, when the
+        # numbers of a build are at hand.
+        def add(generics: dict, max_lut: int, max_ff: int, max_logic: int) -> None:
+            all_generics = dict(address_width=29, **generics)
+            projects.append(
+                TsfpgaExampleVivadoNetlistProject(
+                    name=self.test_case_name(
+                        name=f"{self.library_name}.dma_axi_read_simple_axi_lite",
+                        generics=all_generics,
+                    ),
+                    modules=modules,
+                    part=part,
+                    top="dma_axi_read_simple_axi_lite",
+                    generics=all_generics,
+                    build_result_checkers=[
+                        TotalLuts(LessThan(max_lut + 1)),
+                        Ffs(LessThan(max_ff + 1)),
+                        MaximumLogicLevel(LessThan(max_logic + 1)),
+                    ],
+                )
+            )
+
+        add(
+            generics={"data_width": 64, "packet_length_beats": 1},
+            max_lut=220,
+            max_ff=260,
+            max_logic=16,
+        )
+        add(
+            generics={"data_width": 64, "packet_length_beats": 16},
+            max_lut=220,
+            max_ff=280,
+            max_logic=14,
+        )
+        add(
+            generics={"data_width": 64, "packet_length_beats": 16384},
+            max_lut=200,
+            max_ff=270,
+            max_logic=12,
+        )
+
+        add(
+            generics={"data_width": 32, "packet_length_beats": 16384},
+            max_lut=200,
+            max_ff=270,
+            max_logic=12,
+        )
+        add(
+            generics={"data_width": 128, "packet_length_beats": 16384},
+            max_lut=200,
+            max_ff=270,
+            max_logic=12,
+        )
+
+        return projects
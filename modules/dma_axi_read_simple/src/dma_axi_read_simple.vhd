@@ -0,0 +1,379 @@
+-- -------------------------------------------------------------------------------------------------
+-- Copyright (c) Lukas Vik. All rights reserved.
+--
+-- This file is part of the hdl-modules project, a collection of reusable, high-quality,
+-- peer-reviewed VHDL building blocks.
+-- https://hdl-modules.com
+-- https://github.com/hdl-modules/hdl-modules
+-- -------------------------------------------------------------------------------------------------
+-- Main implementation of the simple read DMA functionality.
+-- This entity is not suitable for instantiation in a user design, use instead e.g.
+-- :ref:`dma_axi_read_simple.dma_axi_read_simple_axi_lite`.
+--
+-- This is the read-direction counterpart of :ref:`dma_axi_write_simple.dma_axi_write_simple`,
+-- and uses the same ring buffer register model, but with the roles of the software and the
+-- FPGA swapped.
+-- The software writes data to the memory buffer and updates the ``buffer_written_address``
+-- register.
+-- The core reads the data and passes it on to the ``stream`` interface, and updates the
+-- ``buffer_read_address`` register as it goes.
+--
+--
+-- Packet length
+-- _____________
+--
+-- The ``packet_length_beats`` generic specifies the packet length in terms of number of
+-- ``stream`` beats.
+-- The memory buffer is read one packet at a time, using one AXI burst per packet.
+-- When one packet has been read from DDR and passed on to the ``stream``,
+-- the ``read_done`` interrupt will trigger and the ``buffer_read_address`` register
+-- will be updated.
+-- This indicates to the software that there is space in the buffer that can be written again.
+--
+-- .. note::
+--   The packet length is a compile-time parameter.
+--   It can not be changed during runtime.
+--   There is no support for reading partial packets.
+--
+--   This saves a lot of resources and is part of the simple nature of this DMA core.
+--
+-- The packet length must fit within one maximum-length AXI burst.
+-- Meaning at most 256 beats, or 16 beats if ``enable_axi3`` is set.
+--
+--
+-- Data width
+-- __________
+--
+-- The ``stream`` data width is the same as the AXI data width, given by the ``data_width``
+-- generic.
+-- It must be the native width of the AXI port, we do not support narrow bursts.
+-- If a different ``stream`` width is needed, :ref:`common.width_conversion` can be used
+-- after this core.
+--
+--
+-- AXI behavior
+-- ____________
+--
+-- 1. An ``AR`` transaction is initiated as soon as there is a packet of data available in the
+--    memory buffer.
+--    There is no limit on the number of outstanding transactions, other than the size of the
+--    memory buffer.
+--
+-- 2. ``RREADY`` is the ``stream_ready`` signal of the user.
+--    Meaning that backpressure on the ``stream`` will be propagated to the AXI bus.
+--    If this is a problem, e.g. if the downstream AXI slave is a crossbar/interconnect that
+--    arbitrates between multiple AXI masters, a FIFO should be placed on the ``stream``.
+--
+-- 3. No ``ARID`` is set.
+--    All responses are hence in order, and the ``buffer_read_address`` is updated on ``RLAST``.
+--
+-- The core will issue back-to-back ``AR`` transactions without any overhead.
+-- Hence the ``stream`` can run at full rate, given that the AXI slave has enough
+-- transaction capability to cover the read latency.
+-- -------------------------------------------------------------------------------------------------
+
+library ieee;
+use ieee.std_logic_1164.all;
+use ieee.numeric_std.all;
+
+library axi;
+use axi.axi_pkg.all;
+
+library common;
+use common.common_pkg.all;
+use common.types_pkg.all;
+
+library math;
+use math.math_pkg.all;
+
+library register_file;
+use register_file.register_file_pkg.all;
+
+use work.dma_axi_read_simple_register_record_pkg.all;
+use work.dma_axi_read_simple_regs_pkg.all;
+
+
+entity dma_axi_read_simple is
+  generic (
+    -- The width of the AXI ARADDR field as well as all the ring buffer addresses
+    -- handled internally.
+    -- If greater than 32, the upper address bits are handled by the '_high' registers.
+    address_width : axi_address_width_t;
+    -- The width of the 'stream' data as well as the AXI RDATA field.
+    -- Must be the native width of the AXI port, we do not support narrow bursts.
+    data_width : axi_data_width_t;
+    -- The number of 'stream' beats in one packet, which is read from memory in one AXI burst.
+    -- Increase this number to improve memory performance.
+    -- Will also decrease the frequency of 'read_done' interrupts.
+    packet_length_beats : positive;
+    -- Enable AXI3 instead of AXI4, with the limitations that this implies.
+    enable_axi3 : boolean
+  );
+  port (
+    clk : in std_ulogic;
+    --# {{}}
+    stream_ready : in std_ulogic;
+    stream_valid : out std_ulogic := '0';
+    stream_data : out std_ulogic_vector(data_width - 1 downto 0) := (others => '0');
+    --# {{}}
+    regs_up : out dma_axi_read_simple_regs_up_t := dma_axi_read_simple_regs_up_init;
+    regs_down : in dma_axi_read_simple_regs_down_t;
+    interrupt : out std_ulogic := '0';
+    --# {{}}
+    axi_read_m2s : out axi_read_m2s_t := axi_read_m2s_init;
+    axi_read_s2m : in axi_read_s2m_t
+  );
+end entity;
+
+architecture a of dma_axi_read_simple is
+
+  ------------------------------------------------------------------------------
+  -- Generic constants.
+  constant data_width_bytes : positive := data_width / 8;
+  constant packet_length_bytes : positive := packet_length_beats * data_width_bytes;
+
+  -- The lowest bits that are assumed to be zero.
+  constant unaligned_address_width : natural := ceil_log2(packet_length_bytes);
+  subtype unaligned_address_range is natural range unaligned_address_width - 1 downto 0;
+
+  -- The bits that we will actually use.
+  constant aligned_address_width : natural := address_width - unaligned_address_width;
+  subtype aligned_address_range is natural range address_width - 1 downto unaligned_address_width;
+
+  subtype buffer_read_address_low_range is
+    natural range minimum(address_width, register_width) - 1 downto 0;
+
+  -- Addresses are split over a low and a high register, in order to support
+  -- 'address_width' greater than 32.
+  function to_address(low, high : register_t) return u_unsigned is
+    constant full : std_ulogic_vector(2 * register_width - 1 downto 0) := high & low;
+  begin
+    return u_unsigned(full(address_width - 1 downto 0));
+  end function;
+
+  ------------------------------------------------------------------------------
+  -- Signals.
+  signal buffer_start_address, buffer_end_address, buffer_written_address, buffer_read_address :
+    u_unsigned(address_width - 1 downto 0) := (others => '0');
+
+  -- The index of the next packet to be requested on the AR channel, and the index of the next
+  -- packet to be finished on the R channel.
+  signal buffer_start_index, buffer_end_index, buffer_written_index, request_index, read_index :
+    u_unsigned(aligned_address_width - 1 downto 0) := (others => '0');
+
+  signal enable_p1 : std_ulogic := '0';
+
+  -- A whole packet has been read from memory and passed on to the 'stream'.
+  signal read_done : std_ulogic := '0';
+
+  signal start_address_unaligned, end_address_unaligned, written_address_unaligned : std_ulogic :=
+    '0';
+
+begin
+
+  ------------------------------------------------------------------------------
+  assert sanity_check_axi_data_width(data_width=>data_width)
+    report "Invalid AXI data width. See above."
+    severity failure;
+
+  assert is_power_of_two(packet_length_beats)
+    report "Packet length must be a power of two for efficient calculations."
+    severity failure;
+
+  assert packet_length_beats <= get_max_burst_length_beats(enable_axi3=>enable_axi3)
+    report "Packet length must fit in one AXI burst."
+    severity failure;
+
+  assert address_width > unaligned_address_width + 1
+    report "Buffer must be able to hold at least two packets."
+    severity failure;
+
+
+  ------------------------------------------------------------------------------
+  interrupt_register_block : block
+    signal clear, status, interrupt_sources : register_t := (others => '0');
+  begin
+
+    ------------------------------------------------------------------------------
+    interrupt_register_inst : entity register_file.interrupt_register
+      port map (
+        clk => clk,
+        --
+        sources => interrupt_sources,
+        mask => regs_down.interrupt_mask,
+        clear => clear,
+        --
+        status => status,
+        trigger => interrupt
+      );
+
+    interrupt_sources(dma_axi_read_simple_interrupt_status_read_done) <= read_done;
+
+    interrupt_sources(dma_axi_read_simple_interrupt_status_read_error) <= (
+      axi_read_m2s.r.ready
+      and axi_read_s2m.r.valid
+      and to_sl(axi_read_s2m.r.resp /= axi_resp_okay)
+    );
+
+    interrupt_sources(dma_axi_read_simple_interrupt_status_start_address_unaligned_error) <= (
+      start_address_unaligned
+    );
+
+    interrupt_sources(dma_axi_read_simple_interrupt_status_end_address_unaligned_error) <= (
+      end_address_unaligned
+    );
+
+    interrupt_sources(dma_axi_read_simple_interrupt_status_written_address_unaligned_error) <= (
+      written_address_unaligned
+    );
+
+    clear <= to_slv(regs_down.interrupt_status);
+
+    regs_up.interrupt_status <= to_dma_axi_read_simple_interrupt_status(status);
+
+  end block;
+
+
+  ------------------------------------------------------------------------------
+  buffer_start_address <= to_address(
+    low=>regs_down.buffer_start_address, high=>regs_down.buffer_start_address_high
+  );
+  buffer_end_address <= to_address(
+    low=>regs_down.buffer_end_address, high=>regs_down.buffer_end_address_high
+  );
+  buffer_written_address <= to_address(
+    low=>regs_down.buffer_written_address, high=>regs_down.buffer_written_address_high
+  );
+
+  buffer_start_index <= buffer_start_address(aligned_address_range);
+  buffer_end_index <= buffer_end_address(aligned_address_range);
+  buffer_written_index <= buffer_written_address(aligned_address_range);
+
+  buffer_read_address(aligned_address_range) <= read_index;
+
+  regs_up.buffer_read_address(buffer_read_address_low_range) <= std_logic_vector(
+    buffer_read_address(buffer_read_address_low_range)
+  );
+
+
+  ------------------------------------------------------------------------------
+  buffer_read_address_high_gen : if address_width > register_width generate
+
+    regs_up.buffer_read_address_high(address_width - register_width - 1 downto 0) <= (
+      std_logic_vector(buffer_read_address(address_width - 1 downto register_width))
+    );
+
+  end generate;
+
+
+  ------------------------------------------------------------------------------
+  assertions_gen : if in_simulation generate
+
+    ------------------------------------------------------------------------------
+    -- A couple of assertions that are very important but also very expensive to do in hardware.
+    -- Hence they are checked only in simulation, but hopefully they can catch some misuse.
+    assertions : process
+    begin
+      wait until regs_down.config.enable = '1' and enable_p1 = '0' and rising_edge(clk);
+
+      assert buffer_end_address > buffer_start_address
+        report "Bad buffer layout";
+
+      assert buffer_written_address = buffer_start_address
+        report "Initial written address should be start address";
+
+      assert buffer_end_address - buffer_start_address >= 2 * packet_length_bytes
+        report "Buffer must be able to hold at least two packets";
+
+      wait;
+    end process;
+
+  end generate;
+
+
+  ------------------------------------------------------------------------------
+  address_handling : process
+    variable request_index_next, read_index_next : u_unsigned(request_index'range) := (
+      others => '0'
+    );
+  begin
+    wait until rising_edge(clk);
+
+    if request_index + 1 = buffer_end_index then
+      request_index_next := buffer_start_index;
+    else
+      request_index_next := request_index + 1;
+    end if;
+
+    if read_index + 1 = buffer_end_index then
+      read_index_next := buffer_start_index;
+    else
+      read_index_next := read_index + 1;
+    end if;
+
+    if axi_read_s2m.ar.ready then
+      axi_read_m2s.ar.valid <= '0';
+    end if;
+
+    if regs_down.config.enable and not enable_p1 then
+      request_index <= buffer_start_index;
+      read_index <= buffer_start_index;
+
+    elsif (
+      regs_down.config.enable = '1'
+      -- There is data in the buffer that we have not yet requested.
+      and request_index /= buffer_written_index
+      -- There is no pending AR transaction, or it is done this clock cycle.
+      and (axi_read_m2s.ar.valid = '0' or axi_read_s2m.ar.ready = '1')
+    ) then
+      axi_read_m2s.ar.valid <= '1';
+      axi_read_m2s.ar.addr(aligned_address_range) <= request_index;
+
+      request_index <= request_index_next;
+    end if;
+
+    if read_done then
+      read_index <= read_index_next;
+    end if;
+
+    enable_p1 <= regs_down.config.enable;
+  end process;
+
+  axi_read_m2s.ar.len <= to_len(burst_length_beats=>packet_length_beats);
+  axi_read_m2s.ar.size <= to_size(data_width_bits=>data_width);
+  axi_read_m2s.ar.burst <= axi_a_burst_incr;
+
+  axi_read_m2s.r.ready <= stream_ready;
+
+  stream_valid <= axi_read_s2m.r.valid;
+  stream_data <= axi_read_s2m.r.data(stream_data'range);
+
+  -- One AXI burst per packet.
+  read_done <= axi_read_m2s.r.ready and axi_read_s2m.r.valid and axi_read_s2m.r.last;
+
+
+  ------------------------------------------------------------------------------
+  set_unaligned_error_gen : if packet_length_bytes > 1 generate
+
+    ------------------------------------------------------------------------------
+    set_unaligned_error : process
+      constant unaligned_address_zero : u_unsigned(unaligned_address_range) := (others => '0');
+    begin
+      wait until rising_edge(clk);
+
+      start_address_unaligned <= to_sl(
+        buffer_start_address(unaligned_address_zero'range) /= unaligned_address_zero
+      );
+
+      end_address_unaligned <= to_sl(
+        buffer_end_address(unaligned_address_zero'range) /= unaligned_address_zero
+      );
+
+      written_address_unaligned <= to_sl(
+        buffer_written_address(unaligned_address_zero'range) /= unaligned_address_zero
+      );
+    end process;
+
+  end generate;
+
+end architecture;
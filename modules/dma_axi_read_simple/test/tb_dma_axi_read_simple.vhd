@@ -0,0 +1,319 @@
+-- -------------------------------------------------------------------------------------------------
+-- Copyright (c) Lukas Vik. All rights reserved.
+--
+-- This file is part of the hdl-modules project, a collection of reusable, high-quality,
+-- peer-reviewed VHDL building blocks.
+-- https://hdl-modules.com
+-- https://github.com/hdl-modules/hdl-modules
+-- -------------------------------------------------------------------------------------------------
+
+library ieee;
+use ieee.numeric_std.all;
+use ieee.std_logic_1164.all;
+
+library osvvm;
+use osvvm.RandomPkg.RandomPType;
+
+library vunit_lib;
+use vunit_lib.axi_slave_pkg.all;
+use vunit_lib.check_pkg.all;
+use vunit_lib.com_pkg.net;
+use vunit_lib.integer_array_pkg.all;
+use vunit_lib.memory_pkg.all;
+use vunit_lib.queue_pkg.all;
+use vunit_lib.random_pkg.all;
+use vunit_lib.run_pkg.all;
+
+library axi;
+use axi.axi_pkg.all;
+
+library axi_lite;
+use axi_lite.axi_lite_pkg.all;
+
+library bfm;
+use bfm.stall_bfm_pkg.all;
+
+use work.dma_axi_read_simple_register_read_write_pkg.all;
+use work.dma_axi_read_simple_register_record_pkg.all;
+
+
+entity tb_dma_axi_read_simple is
+  generic (
+    seed : natural;
+    runner_cfg : string
+  );
+end entity;
+
+architecture tb of tb_dma_axi_read_simple is
+
+  -- ---------------------------------------------------------------------------
+  -- Generic constants.
+  shared variable rnd : RandomPType;
+  impure function initialize_and_get_address_width return positive is
+  begin
+    rnd.InitSeed(seed);
+    return rnd.Uniform(25, 32);
+  end function;
+  constant address_width : positive := initialize_and_get_address_width;
+
+  impure function get_data_width return positive is
+  begin
+    -- Between 8 and 128 bits.
+    return 8 * 2 ** rnd.Uniform(0, 4);
+  end function;
+  constant data_width : positive := get_data_width;
+  constant bytes_per_beat : positive := data_width / 8;
+
+  impure function get_enable_axi3 return boolean is
+  begin
+    return rnd.RandBool;
+  end function;
+  constant enable_axi3 : boolean := get_enable_axi3;
+
+  impure function get_packet_length_beats return positive is
+  begin
+    if enable_axi3 then
+      -- Between 1 and 16 beats.
+      return 2 ** rnd.FavorSmall(0, 4);
+    end if;
+
+    -- Between 1 and 256 beats.
+    return 2 ** rnd.FavorSmall(0, 8);
+  end function;
+  constant packet_length_beats : positive := get_packet_length_beats;
+  constant packet_length_bytes : positive := packet_length_beats * bytes_per_beat;
+
+  -- ---------------------------------------------------------------------------
+  -- DUT connections.
+  constant clk_period : time := 10 ns;
+  signal clk : std_ulogic := '0';
+
+  signal stream_ready, stream_valid : std_ulogic := '0';
+  signal stream_data : std_ulogic_vector(data_width - 1 downto 0) := (others => '0');
+
+  signal axi_m2s : axi_read_m2s_t := axi_read_m2s_init;
+  signal axi_s2m : axi_read_s2m_t := axi_read_s2m_init;
+
+  signal regs_m2s : axi_lite_m2s_t := axi_lite_m2s_init;
+  signal regs_s2m : axi_lite_s2m_t := axi_lite_s2m_init;
+
+  -- ---------------------------------------------------------------------------
+  -- Testbench stuff.
+  constant memory : memory_t := new_memory;
+  constant axi_slave : axi_slave_t := new_axi_slave(
+    address_fifo_depth => 4,
+    memory => memory,
+    address_stall_probability => 0.8,
+    data_stall_probability => 0.5,
+    min_response_latency => clk_period,
+    max_response_latency => 20 * clk_period
+  );
+
+  constant stall_config : stall_configuration_t := (
+    stall_probability => 0.2,
+    min_stall_cycles => 1,
+    max_stall_cycles => 4
+  );
+
+  constant reference_data_queue : queue_t := new_queue;
+  signal num_packets_checked : natural := 0;
+
+begin
+
+  test_runner_watchdog(runner, 10 ms);
+  clk <= not clk after 5 ns;
+
+
+  ------------------------------------------------------------------------------
+  main : process
+    constant buffer_size_packets : positive := rnd.FavorSmall(2, 5);
+    constant buffer_size_bytes : positive := buffer_size_packets * packet_length_bytes;
+
+    -- Make it roll around a few times.
+    constant test_data_num_bytes : positive := 3 * buffer_size_bytes;
+
+    variable data : integer_array_t := null_integer_array;
+    variable buf : buffer_t := null_buffer;
+
+    variable written_address, read_address : natural := 0;
+    variable num_bytes_occupied, num_bytes_written : natural := 0;
+
+    variable interrupt_status : dma_axi_read_simple_interrupt_status_t := (
+      dma_axi_read_simple_interrupt_status_init
+    );
+  begin
+    test_runner_setup(runner, runner_cfg);
+
+    report "address_width = " & to_string(address_width);
+    report "data_width = " & to_string(data_width);
+    report "packet_length_beats = " & to_string(packet_length_beats);
+    report "enable_axi3 = " & to_string(enable_axi3);
+    report "buffer_size_packets = " & to_string(buffer_size_packets);
+
+    random_integer_array(
+      rnd => rnd,
+      integer_array => data,
+      width => test_data_num_bytes,
+      bits_per_word => 8,
+      is_signed => false
+    );
+    push_ref(reference_data_queue, copy(data));
+
+    buf := allocate(
+      memory => memory,
+      num_bytes => 3,
+      name=>"padding so we start on non-zero address",
+      permissions=>no_access
+    );
+    buf := allocate(
+      memory => memory,
+      num_bytes => buffer_size_bytes,
+      name=>"dma_axi_read_simple_test_buffer",
+      alignment=>packet_length_bytes,
+      permissions=>read_only
+    );
+
+    write_dma_axi_read_simple_buffer_start_address(net=>net, value=>base_address(buf));
+    write_dma_axi_read_simple_buffer_end_address(net=>net, value=>last_address(buf) + 1);
+    write_dma_axi_read_simple_buffer_written_address(net=>net, value=>base_address(buf));
+    written_address := base_address(buf);
+
+    write_dma_axi_read_simple_config(net=>net, value=>(enable=>'1'));
+
+    while num_bytes_written /= test_data_num_bytes loop
+      read_dma_axi_read_simple_buffer_read_address(net=>net, value=>read_address);
+
+      if written_address >= read_address then
+        num_bytes_occupied := written_address - read_address;
+      else
+        num_bytes_occupied := written_address + buffer_size_bytes - read_address;
+      end if;
+
+      -- The very last packet of the buffer must never be filled, since a full buffer would be
+      -- indistinguishable from an empty one.
+      while (
+        num_bytes_occupied < buffer_size_bytes - packet_length_bytes
+        and num_bytes_written /= test_data_num_bytes
+      ) loop
+        -- At a 12.5% probability, stop producing before we have filled all the space that is
+        -- actually available.
+        exit when rnd.Uniform(1, 8) = 8;
+
+        for byte_idx in 0 to packet_length_bytes - 1 loop
+          write_byte(
+            memory=>memory,
+            address=>written_address,
+            byte=>get(arr=>data, idx=>num_bytes_written)
+          );
+          num_bytes_written := num_bytes_written + 1;
+
+          if written_address = last_address(buf) then
+            written_address := base_address(buf);
+          else
+            written_address := written_address + 1;
+          end if;
+        end loop;
+
+        num_bytes_occupied := num_bytes_occupied + packet_length_bytes;
+      end loop;
+
+      -- Note that there is a possibility that we might not have produced any data at all.
+      write_dma_axi_read_simple_buffer_written_address(net=>net, value=>written_address);
+    end loop;
+
+    wait until num_packets_checked = 1 and rising_edge(clk);
+
+    -- All data has been read, so the module shall have caught up with the software.
+    read_dma_axi_read_simple_buffer_read_address(net=>net, value=>read_address);
+    check_equal(read_address, written_address, "buffer_read_address");
+
+    read_dma_axi_read_simple_interrupt_status(net=>net, value=>interrupt_status);
+    check_equal(interrupt_status.read_done, '1', "read_done");
+    check_equal(interrupt_status.read_error, '0', "read_error");
+    check_equal(
+      interrupt_status.start_address_unaligned_error, '0', "start_address_unaligned_error"
+    );
+    check_equal(interrupt_status.end_address_unaligned_error, '0', "end_address_unaligned_error");
+    check_equal(
+      interrupt_status.written_address_unaligned_error, '0', "written_address_unaligned_error"
+    );
+
+    -- No extra data shall have been read.
+    wait for 50 * clk_period;
+    check_equal(stream_valid, '0', "stream_valid");
+
+    deallocate(data);
+
+    test_runner_cleanup(runner);
+  end process;
+
+
+  ------------------------------------------------------------------------------
+  axi_stream_slave_inst : entity bfm.axi_stream_slave
+    generic map (
+      data_width => stream_data'length,
+      reference_data_queue => reference_data_queue,
+      stall_config => stall_config,
+      seed => seed,
+      logger_name_suffix => " - stream",
+      disable_last_check => true
+    )
+    port map (
+      clk => clk,
+      --
+      ready => stream_ready,
+      valid => stream_valid,
+      data => stream_data,
+      --
+      num_packets_checked => num_packets_checked
+    );
+
+
+  ------------------------------------------------------------------------------
+  axi_lite_master_inst : entity bfm.axi_lite_master
+    port map (
+      clk => clk,
+      --
+      axi_lite_m2s => regs_m2s,
+      axi_lite_s2m => regs_s2m
+    );
+
+
+  ------------------------------------------------------------------------------
+  axi_slave_inst : entity bfm.axi_read_slave
+    generic map (
+      axi_slave => axi_slave,
+      data_width => data_width,
+      id_width => 0
+    )
+    port map (
+      clk => clk,
+      --
+      axi_read_m2s => axi_m2s,
+      axi_read_s2m => axi_s2m
+    );
+
+
+  ------------------------------------------------------------------------------
+  dut : entity work.dma_axi_read_simple_axi_lite
+    generic map (
+      address_width => address_width,
+      data_width => data_width,
+      packet_length_beats => packet_length_beats,
+      enable_axi3 => enable_axi3
+    )
+    port map (
+      clk => clk,
+      --
+      stream_ready => stream_ready,
+      stream_valid => stream_valid,
+      stream_data => stream_data,
+      --
+      regs_m2s => regs_m2s,
+      regs_s2m => regs_s2m,
+      --
+      axi_read_m2s => axi_m2s,
+      axi_read_s2m => axi_s2m
+    );
+
+end architecture;
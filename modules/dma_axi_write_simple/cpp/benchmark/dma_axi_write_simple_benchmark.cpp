@@ -0,0 +1,344 @@
+// -------------------------------------------------------------------------------------------------
+// Copyright (c) Lukas Vik. All rights reserved.
+//
+// This file is part of the hdl-modules project, a collection of reusable, high-quality,
+// peer-reviewed VHDL building blocks.
+// https://hdl-modules.com
+// https://github.com/hdl-modules/hdl-modules
+// -------------------------------------------------------------------------------------------------
+// Host-side benchmark of the DmaNoCopy driver, for catching performance
+// regressions in the receive hot path without any hardware.
+//
+// The driver is run against registers in ordinary memory, with a software
+// model of the FPGA module that writes packets to the ring buffer and updates
+// 'buffer_written_address'.
+// The model does not write any actual data, since this benchmark measures the
+// overhead of the driver, not memory bandwidth.
+// Hence the 'handout_GB/s' column is the rate at which buffer space is handed
+// out by the driver, which is an upper bound of what an application that
+// touches the data could reach.
+//
+// One packet is received with each DmaNoCopy::receive_data call, and released
+// with DmaNoCopy::done_with_data right away.
+// The register accesses of the driver are counted, using a register interface
+// that is given to the DmaNoCopy constructor.
+//
+// Two modes are measured:
+// - inline: The model is stepped by the benchmark thread, before each receive
+//   call, so that all free buffer space is always filled.
+//   This gives the pure cost of the driver calls.
+// - threaded: The model runs in a separate thread, like the FPGA would.
+//   This includes the cost of the two sides sharing the registers, which are
+//   atomic, and will give some empty receive calls.
+//
+// Build with the generated register code from hdl-registers, e.g.
+//
+//   g++ -std=c++17 -O2 -pthread -I<generated>/include -Iinclude
+//     benchmark/dma_axi_write_simple_benchmark.cpp
+//     dma_axi_write_simple_no_copy.cpp <generated>/dma_axi_write_simple.cpp
+//
+// from the 'cpp' folder of the module.
+// -------------------------------------------------------------------------------------------------
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+
+#include "dma_axi_write_simple_no_copy.h"
+
+namespace {
+
+using fpga::dma_axi_write_simple::DmaNoCopy;
+using fpga::dma_axi_write_simple::Response;
+
+// Enough to hold all registers of the module.
+const size_t num_registers = 64;
+
+// The number of bytes to receive in each benchmark case.
+const size_t num_bytes_per_case = 64 * 1024 * 1024;
+
+bool assertion_handler(const std::string *diagnostic_message) {
+  std::fprintf(stderr, "%s\n", diagnostic_message->c_str());
+  std::abort();
+
+  return true;
+}
+
+/**
+ * The registers that the FPGA model accesses.
+ * Atomic, since in threaded mode they are accessed by both the driver thread
+ * and the model thread.
+ * Accessed by name, via the register interface below, so that nothing depends
+ * on the register order in 'regs_dma_axi_write_simple.toml'.
+ */
+struct SharedRegisters {
+  std::atomic<uint32_t> buffer_start_address{0};
+  std::atomic<uint32_t> buffer_end_address{0};
+  std::atomic<uint32_t> buffer_written_address{0};
+  std::atomic<uint32_t> buffer_read_address{0};
+};
+
+/**
+ * Register interface that counts the register accesses that are made in the
+ * receive path of the driver.
+ * Each access is one AXI-Lite transaction on real hardware.
+ *
+ * The registers that are shared with the FPGA model are kept in
+ * SharedRegisters.
+ * All other registers are accessed by the generated code in a plain register
+ * bank, that is only used by the driver thread.
+ */
+class CountingRegisters : public fpga_regs::DmaAxiWriteSimple {
+
+private:
+  SharedRegisters &m_shared;
+
+public:
+  mutable uint64_t num_reads = 0;
+  mutable uint64_t num_writes = 0;
+
+  CountingRegisters(uintptr_t base_address, SharedRegisters &shared)
+      : fpga_regs::DmaAxiWriteSimple(base_address, assertion_handler),
+        m_shared(shared) {}
+
+  uint32_t get_interrupt_status() const override {
+    ++num_reads;
+    return fpga_regs::DmaAxiWriteSimple::get_interrupt_status();
+  }
+
+  void set_interrupt_status(uint32_t register_value) const override {
+    ++num_writes;
+    fpga_regs::DmaAxiWriteSimple::set_interrupt_status(register_value);
+  }
+
+  void set_buffer_start_address(uint32_t register_value) const override {
+    m_shared.buffer_start_address.store(register_value,
+                                        std::memory_order_relaxed);
+  }
+
+  void set_buffer_end_address(uint32_t register_value) const override {
+    m_shared.buffer_end_address.store(register_value,
+                                      std::memory_order_relaxed);
+  }
+
+  uint32_t get_buffer_written_address() const override {
+    ++num_reads;
+    // Acquire, like the data would be visible once the address has been read
+    // on real hardware.
+    return m_shared.buffer_written_address.load(std::memory_order_acquire);
+  }
+
+  void set_buffer_read_address(uint32_t register_value) const override {
+    ++num_writes;
+    // Release, so that the driver is done with the data before the model can
+    // write it again.
+    m_shared.buffer_read_address.store(register_value,
+                                       std::memory_order_release);
+  }
+};
+
+/**
+ * Software model of the FPGA module.
+ * Accesses the registers the same way the FPGA module would.
+ */
+class FpgaModel {
+
+private:
+  SharedRegisters &m_registers;
+  uint32_t m_packet_length_bytes;
+
+  std::atomic<bool> m_stop{false};
+  std::thread m_thread;
+
+public:
+  FpgaModel(SharedRegisters &registers, size_t packet_length_bytes)
+      : m_registers(registers),
+        m_packet_length_bytes(static_cast<uint32_t>(packet_length_bytes)) {}
+
+  ~FpgaModel() { stop(); }
+
+  /**
+   * Write packets until the buffer is full.
+   * Must not be called before the driver has enabled the module.
+   *
+   * @return 'true' if any packet was written.
+   */
+  bool step() {
+    const uint32_t start_address =
+        m_registers.buffer_start_address.load(std::memory_order_relaxed);
+    const uint32_t end_address =
+        m_registers.buffer_end_address.load(std::memory_order_relaxed);
+    const uint32_t read_address =
+        m_registers.buffer_read_address.load(std::memory_order_acquire);
+
+    // The very last packet before the read address is never written, since a
+    // full buffer would be indistinguishable from an empty one.
+    const uint32_t written_address =
+        (read_address == start_address ? end_address : read_address) -
+        m_packet_length_bytes;
+
+    if (written_address ==
+        m_registers.buffer_written_address.load(std::memory_order_relaxed)) {
+      // Buffer is full.
+      return false;
+    }
+
+    m_registers.buffer_written_address.store(written_address,
+                                             std::memory_order_release);
+
+    return true;
+  }
+
+  /**
+   * Run the model in a separate thread until FpgaModel::stop is called.
+   */
+  void start() {
+    m_thread = std::thread([this]() {
+      while (!m_stop.load(std::memory_order_relaxed)) {
+        if (!step()) {
+          // In case the two threads share a CPU core.
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+
+  void stop() {
+    m_stop.store(true, std::memory_order_relaxed);
+    if (m_thread.joinable()) {
+      m_thread.join();
+    }
+  }
+};
+
+struct Result {
+  uint64_t num_receive_calls;
+  uint64_t num_empty_receive_calls;
+  double ns_per_call;
+  double register_reads_per_call;
+  double register_writes_per_call;
+  // The rate at which the driver hands out buffer space, in GB/s.
+  // Not memory bandwidth, since the data is never written or read.
+  double handout_gigabytes_per_second;
+};
+
+Result run_case(size_t packet_length_bytes, size_t buffer_size_bytes,
+                bool threaded, bool written_address_caching) {
+  // Registers that are not shared with the FPGA model.
+  alignas(64) static volatile uint32_t registers[num_registers];
+  for (size_t register_index = 0; register_index < num_registers;
+       ++register_index) {
+    registers[register_index] = 0;
+  }
+
+  SharedRegisters shared_registers;
+
+  void *buffer = std::aligned_alloc(packet_length_bytes, buffer_size_bytes);
+
+  CountingRegisters counting_registers(reinterpret_cast<uintptr_t>(registers),
+                                       shared_registers);
+  DmaNoCopy dma(&counting_registers, reinterpret_cast<uintptr_t>(buffer),
+                buffer, buffer_size_bytes, assertion_handler);
+  dma.set_written_address_caching(written_address_caching);
+  dma.setup_and_enable();
+  // Count only the receive path.
+  counting_registers.num_reads = 0;
+  counting_registers.num_writes = 0;
+  // Done by the FPGA upon enable.
+  shared_registers.buffer_written_address.store(
+      shared_registers.buffer_start_address.load(std::memory_order_relaxed),
+      std::memory_order_relaxed);
+
+  FpgaModel fpga(shared_registers, packet_length_bytes);
+  if (threaded) {
+    fpga.start();
+  }
+
+  uint64_t num_receive_calls = 0;
+  uint64_t num_empty_receive_calls = 0;
+  size_t num_bytes_received = 0;
+
+  const auto start_time = std::chrono::steady_clock::now();
+
+  while (num_bytes_received < num_bytes_per_case) {
+    if (!threaded) {
+      fpga.step();
+    }
+
+    // One packet per call, which is the typical use case.
+    const Response response =
+        dma.receive_data(packet_length_bytes, packet_length_bytes);
+    ++num_receive_calls;
+
+    if (response.num_bytes == 0) {
+      ++num_empty_receive_calls;
+      // In case the two threads share a CPU core.
+      std::this_thread::yield();
+      continue;
+    }
+
+    dma.done_with_data(response.num_bytes);
+    num_bytes_received += response.num_bytes;
+  }
+
+  const auto end_time = std::chrono::steady_clock::now();
+
+  fpga.stop();
+  std::free(buffer);
+
+  const double elapsed_ns = static_cast<double>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(end_time -
+                                                           start_time)
+          .count());
+
+  // Note that a call is one receive_data call, plus one done_with_data call if
+  // data was received.
+  const double num_calls = static_cast<double>(num_receive_calls);
+
+  return {num_receive_calls,
+          num_empty_receive_calls,
+          elapsed_ns / num_calls,
+          static_cast<double>(counting_registers.num_reads) / num_calls,
+          static_cast<double>(counting_registers.num_writes) / num_calls,
+          static_cast<double>(num_bytes_received) / elapsed_ns};
+}
+
+} // namespace
+
+int main() {
+  const size_t packet_lengths_bytes[] = {64, 1024, 16 * 1024};
+  const size_t buffer_sizes_bytes[] = {64 * 1024, 1024 * 1024,
+                                       16 * 1024 * 1024};
+
+  std::printf("%-9s %-8s %-12s %-10s %12s %8s %10s %10s %10s %12s\n", "mode",
+              "caching", "packet_bytes", "buffer_kib", "calls", "empty_%",
+              "ns/call", "reads/call", "writes/call", "handout_GB/s");
+
+  for (const bool threaded : {false, true}) {
+    for (const bool caching : {false, true}) {
+      for (const size_t packet_length_bytes : packet_lengths_bytes) {
+        for (const size_t buffer_size_bytes : buffer_sizes_bytes) {
+          const Result result = run_case(packet_length_bytes,
+                                         buffer_size_bytes, threaded, caching);
+
+          std::printf(
+              "%-9s %-8s %-12zu %-10zu %12llu %8.1f %10.1f %10.3f %10.3f "
+              "%12.2f\n",
+              threaded ? "threaded" : "inline", caching ? "on" : "off",
+              packet_length_bytes, buffer_size_bytes / 1024,
+              static_cast<unsigned long long>(result.num_receive_calls),
+              100.0 * static_cast<double>(result.num_empty_receive_calls) /
+                  static_cast<double>(result.num_receive_calls),
+              result.ns_per_call, result.register_reads_per_call,
+              result.register_writes_per_call,
+              result.handout_gigabytes_per_second);
+        }
+      }
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,201 @@
+// -------------------------------------------------------------------------------------------------
+// Copyright (c) Lukas Vik. All rights reserved.
+//
+// This file is part of the hdl-modules project, a collection of reusable, high-quality,
+// peer-reviewed VHDL building blocks.
+// https://hdl-modules.com
+// https://github.com/hdl-modules/hdl-modules
+// -------------------------------------------------------------------------------------------------
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "include/dma_axi_write_simple_dma_buffer.h"
+
+namespace fpga {
+
+namespace dma_axi_write_simple {
+
+// Returns zero if the size could not be found.
+static size_t get_huge_page_size_bytes() {
+  FILE *file = std::fopen("/proc/meminfo", "r");
+  if (file == nullptr) {
+    return 0;
+  }
+
+  char line[128];
+  size_t huge_page_size_kib = 0;
+  while (std::fgets(line, sizeof(line), file) != nullptr) {
+    if (std::sscanf(line, "Hugepagesize: %zu kB", &huge_page_size_kib) == 1) {
+      break;
+    }
+  }
+
+  std::fclose(file);
+
+  return huge_page_size_kib * 1024;
+}
+
+static bool read_physical_address(int pagemap_file_descriptor,
+                                  const void *virtual_address,
+                                  uint64_t *physical_address) {
+  const uint64_t page_size = static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+  const uint64_t address = reinterpret_cast<uintptr_t>(virtual_address);
+
+  // One 64-bit entry per page.
+  uint64_t entry = 0;
+  const off_t offset = static_cast<off_t>(address / page_size * sizeof(entry));
+  if (pread(pagemap_file_descriptor, &entry, sizeof(entry), offset) !=
+      sizeof(entry)) {
+    return false;
+  }
+
+  // Bit 63 is 'page present', and bits 54 to 0 are the page frame number.
+  // The frame number reads as zero without the 'CAP_SYS_ADMIN' capability.
+  const uint64_t frame_number = entry & ((uint64_t(1) << 55) - 1);
+  if ((entry >> 63) == 0 || frame_number == 0) {
+    return false;
+  }
+
+  *physical_address = frame_number * page_size + address % page_size;
+
+  return true;
+}
+
+static bool read_sysfs_value(const std::string &path, uint64_t *value) {
+  FILE *file = std::fopen(path.c_str(), "r");
+  if (file == nullptr) {
+    return false;
+  }
+
+  char line[64];
+  const bool is_read = std::fgets(line, sizeof(line), file) != nullptr;
+  std::fclose(file);
+
+  if (!is_read) {
+    return false;
+  }
+
+  // Base zero accepts both the hexadecimal 'phys_addr', with a '0x' prefix,
+  // and the decimal 'size'.
+  char *end = nullptr;
+  const unsigned long long result = std::strtoull(line, &end, 0);
+  if (end == line) {
+    return false;
+  }
+
+  *value = static_cast<uint64_t>(result);
+
+  return true;
+}
+
+DmaBuffer::DmaBuffer(size_t buffer_size_bytes) {
+  const size_t huge_page_size_bytes = get_huge_page_size_bytes();
+  if (buffer_size_bytes == 0 || huge_page_size_bytes == 0) {
+    return;
+  }
+
+  const size_t mapping_size_bytes =
+      (buffer_size_bytes + huge_page_size_bytes - 1) / huge_page_size_bytes *
+      huge_page_size_bytes;
+
+  // Populate and lock, so that all pages are present and are not swapped out.
+  // Shared, so that a 'fork' does not give copy-on-write pages that could be
+  // replaced behind the back of the FPGA.
+  // Note that this does not prevent the kernel from migrating the pages, see
+  // the header.
+  void *mapping = mmap(nullptr, mapping_size_bytes, PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_ANONYMOUS | MAP_HUGETLB |
+                           MAP_POPULATE | MAP_LOCKED,
+                       -1, 0);
+  if (mapping == MAP_FAILED) {
+    return;
+  }
+
+  uint8_t *data = static_cast<uint8_t *>(mapping);
+
+  const int pagemap_file_descriptor = open("/proc/self/pagemap", O_RDONLY);
+  uint64_t physical_address = 0;
+  bool is_contiguous =
+      pagemap_file_descriptor >= 0 &&
+      read_physical_address(pagemap_file_descriptor, data, &physical_address);
+
+  // Each huge page is contiguous in itself, but they are not necessarily
+  // contiguous with each other.
+  for (size_t offset = huge_page_size_bytes;
+       is_contiguous && offset < mapping_size_bytes;
+       offset += huge_page_size_bytes) {
+    uint64_t page_physical_address = 0;
+    is_contiguous =
+        read_physical_address(pagemap_file_descriptor, data + offset,
+                              &page_physical_address) &&
+        page_physical_address == physical_address + offset;
+  }
+
+  if (pagemap_file_descriptor >= 0) {
+    close(pagemap_file_descriptor);
+  }
+
+  if (!is_contiguous) {
+    munmap(mapping, mapping_size_bytes);
+    return;
+  }
+
+  m_data = data;
+  m_physical_address = physical_address;
+  m_buffer_size_bytes = buffer_size_bytes;
+  m_mapping_size_bytes = mapping_size_bytes;
+}
+
+DmaBuffer::DmaBuffer(const char *device_name, bool cacheable) {
+  const std::string sysfs_path =
+      std::string("/sys/class/u-dma-buf/") + device_name + "/";
+
+  uint64_t physical_address = 0;
+  uint64_t buffer_size_bytes = 0;
+  if (!read_sysfs_value(sysfs_path + "phys_addr", &physical_address) ||
+      !read_sysfs_value(sysfs_path + "size", &buffer_size_bytes) ||
+      buffer_size_bytes == 0) {
+    return;
+  }
+
+  // With 'O_SYNC', the 'u-dma-buf' driver gives an uncached mapping.
+  const std::string device_path = std::string("/dev/") + device_name;
+  const int file_descriptor =
+      open(device_path.c_str(), O_RDWR | (cacheable ? 0 : O_SYNC));
+  if (file_descriptor < 0) {
+    return;
+  }
+
+  void *mapping = mmap(nullptr, buffer_size_bytes, PROT_READ | PROT_WRITE,
+                       MAP_SHARED, file_descriptor, 0);
+  if (mapping == MAP_FAILED) {
+    close(file_descriptor);
+    return;
+  }
+
+  m_data = static_cast<uint8_t *>(mapping);
+  m_physical_address = physical_address;
+  m_buffer_size_bytes = buffer_size_bytes;
+  m_mapping_size_bytes = buffer_size_bytes;
+  m_file_descriptor = file_descriptor;
+}
+
+DmaBuffer::~DmaBuffer() {
+  if (m_data != nullptr) {
+    munmap(m_data, m_mapping_size_bytes);
+  }
+
+  if (m_file_descriptor >= 0) {
+    close(m_file_descriptor);
+  }
+}
+
+} // namespace dma_axi_write_simple
+
+} // namespace fpga
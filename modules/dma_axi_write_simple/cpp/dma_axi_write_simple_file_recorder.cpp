@@ -0,0 +1,289 @@
+// -------------------------------------------------------------------------------------------------
+// Copyright (c) Lukas Vik. All rights reserved.
+//
+// This file is part of the hdl-modules project, a collection of reusable, high-quality,
+// peer-reviewed VHDL building blocks.
+// https://hdl-modules.com
+// https://github.com/hdl-modules/hdl-modules
+// -------------------------------------------------------------------------------------------------
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "include/dma_axi_write_simple_file_recorder.h"
+
+namespace fpga {
+
+namespace dma_axi_write_simple {
+
+static void *map_ring(int ring_file_descriptor, size_t size_bytes,
+                      off_t offset) {
+  void *result =
+      mmap(nullptr, size_bytes, PROT_READ | PROT_WRITE,
+           MAP_SHARED | MAP_POPULATE, ring_file_descriptor, offset);
+
+  return result == MAP_FAILED ? nullptr : result;
+}
+
+FileRecorder::FileRecorder(DmaNoCopy &dma, int file_descriptor,
+                           size_t write_size_bytes, size_t packet_length_bytes,
+                           size_t queue_depth)
+    : m_dma(dma), m_file_descriptor(file_descriptor),
+      m_write_size_bytes(write_size_bytes), m_queue_depth(queue_depth) {
+  // Each write must be whole packets, and the writes must tile the buffer
+  // exactly, which 'poll' relies on.
+  if (packet_length_bytes == 0 || write_size_bytes == 0 ||
+      write_size_bytes % packet_length_bytes != 0 ||
+      dma.get_buffer_size_bytes() % write_size_bytes != 0 ||
+      queue_depth == 0 || queue_depth > max_queue_depth) {
+    return;
+  }
+
+  struct io_uring_params params = {};
+  m_ring_file_descriptor = static_cast<int>(syscall(
+      __NR_io_uring_setup, static_cast<uint32_t>(queue_depth), &params));
+  if (m_ring_file_descriptor < 0) {
+    m_ring_file_descriptor = -1;
+    return;
+  }
+
+  m_submission_ring_size_bytes =
+      params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+  const size_t completion_ring_size_bytes =
+      params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+
+  if (params.features & IORING_FEAT_SINGLE_MMAP) {
+    // Both rings are in the same mapping.
+    m_submission_ring_size_bytes =
+        std::max(m_submission_ring_size_bytes, completion_ring_size_bytes);
+  } else {
+    m_completion_ring_size_bytes = completion_ring_size_bytes;
+  }
+
+  m_submission_ring =
+      map_ring(m_ring_file_descriptor, m_submission_ring_size_bytes,
+               IORING_OFF_SQ_RING);
+  m_completion_ring =
+      m_completion_ring_size_bytes == 0
+          ? m_submission_ring
+          : map_ring(m_ring_file_descriptor, m_completion_ring_size_bytes,
+                     IORING_OFF_CQ_RING);
+  m_submission_entries_size_bytes =
+      params.sq_entries * sizeof(struct io_uring_sqe);
+  m_submission_entries =
+      map_ring(m_ring_file_descriptor, m_submission_entries_size_bytes,
+               IORING_OFF_SQES);
+
+  if (m_submission_ring == nullptr || m_completion_ring == nullptr ||
+      m_submission_entries == nullptr) {
+    close_ring();
+    return;
+  }
+
+  uint8_t *submission_ring = static_cast<uint8_t *>(m_submission_ring);
+  m_submission_tail =
+      reinterpret_cast<uint32_t *>(submission_ring + params.sq_off.tail);
+  m_submission_mask =
+      *reinterpret_cast<uint32_t *>(submission_ring + params.sq_off.ring_mask);
+  m_submission_array =
+      reinterpret_cast<uint32_t *>(submission_ring + params.sq_off.array);
+
+  uint8_t *completion_ring = static_cast<uint8_t *>(m_completion_ring);
+  m_completion_head =
+      reinterpret_cast<uint32_t *>(completion_ring + params.cq_off.head);
+  m_completion_tail =
+      reinterpret_cast<uint32_t *>(completion_ring + params.cq_off.tail);
+  m_completion_mask =
+      *reinterpret_cast<uint32_t *>(completion_ring + params.cq_off.ring_mask);
+  m_completion_entries = completion_ring + params.cq_off.cqes;
+}
+
+FileRecorder::~FileRecorder() {
+  if (is_valid()) {
+    finish();
+  }
+
+  close_ring();
+}
+
+void FileRecorder::close_ring() {
+  if (m_submission_entries != nullptr) {
+    munmap(m_submission_entries, m_submission_entries_size_bytes);
+    m_submission_entries = nullptr;
+  }
+
+  if (m_completion_ring_size_bytes != 0 && m_completion_ring != nullptr) {
+    munmap(m_completion_ring, m_completion_ring_size_bytes);
+  }
+  m_completion_ring = nullptr;
+
+  if (m_submission_ring != nullptr) {
+    munmap(m_submission_ring, m_submission_ring_size_bytes);
+    m_submission_ring = nullptr;
+  }
+
+  if (m_ring_file_descriptor >= 0) {
+    close(m_ring_file_descriptor);
+    m_ring_file_descriptor = -1;
+  }
+}
+
+bool FileRecorder::enter(uint32_t min_num_completions) {
+  if (m_num_entries_to_submit == 0 && min_num_completions == 0) {
+    return true;
+  }
+
+  const uint32_t flags = min_num_completions > 0 ? IORING_ENTER_GETEVENTS : 0;
+  const long result =
+      syscall(__NR_io_uring_enter, m_ring_file_descriptor,
+              m_num_entries_to_submit, min_num_completions, flags, nullptr, 0);
+
+  if (result < 0) {
+    // Interrupted by a signal, or temporarily out of resources.
+    // The entries are still in the ring, so try again on the next call.
+    if (errno == EINTR || errno == EAGAIN || errno == EBUSY) {
+      return true;
+    }
+
+    if (m_error == 0) {
+      m_error = -errno;
+    }
+    return false;
+  }
+
+  // The kernel might not have consumed all entries.
+  // The rest will be submitted with the next call.
+  m_num_entries_to_submit -= static_cast<uint32_t>(result);
+
+  return true;
+}
+
+bool FileRecorder::reap_completions(uint32_t min_num_completions) {
+  if (!enter(min_num_completions)) {
+    return false;
+  }
+
+  const struct io_uring_cqe *completion_entries =
+      static_cast<const struct io_uring_cqe *>(m_completion_entries);
+
+  // Acquire, so that the completion entries are read after the kernel has
+  // written them.
+  uint32_t head = *m_completion_head;
+  const uint32_t tail = __atomic_load_n(m_completion_tail, __ATOMIC_ACQUIRE);
+
+  while (head != tail) {
+    const struct io_uring_cqe &entry =
+        completion_entries[head & m_completion_mask];
+
+    if (entry.res == static_cast<int32_t>(m_write_size_bytes)) {
+      m_num_bytes_written += m_write_size_bytes;
+    } else if (m_error == 0) {
+      m_error = entry.res < 0 ? entry.res : -EIO;
+    }
+
+    // Release also if the write failed, so that the FPGA is not stalled.
+    m_dma.release_token(static_cast<size_t>(entry.user_data));
+    --m_num_writes_in_flight;
+
+    ++head;
+  }
+
+  // Release, so that the kernel does not overwrite the entries before we are
+  // done with them.
+  __atomic_store_n(m_completion_head, head, __ATOMIC_RELEASE);
+
+  m_dma.collect_released_tokens();
+
+  return true;
+}
+
+bool FileRecorder::poll() {
+  if (!is_valid()) {
+    return false;
+  }
+
+  reap_completions(0);
+
+  if (m_error != 0) {
+    return false;
+  }
+
+  struct io_uring_sqe *submission_entries =
+      static_cast<struct io_uring_sqe *>(m_submission_entries);
+
+  while (m_num_writes_in_flight < m_queue_depth) {
+    // The read position starts at the beginning of the buffer and advances by
+    // exactly the write size, and the buffer size is a multiple of the write
+    // size (checked in the constructor).
+    // So the data of one write is never split at the end of the buffer.
+    // Since the write size is also a multiple of the packet length, every
+    // write contains whole packets.
+    const TokenResponse response =
+        m_dma.receive_data_token(m_write_size_bytes, m_write_size_bytes);
+    if (response.num_bytes == 0) {
+      break;
+    }
+
+    // Only this thread writes the tail.
+    const uint32_t tail = *m_submission_tail;
+    const uint32_t index = tail & m_submission_mask;
+
+    struct io_uring_sqe &entry = submission_entries[index];
+    std::memset(&entry, 0, sizeof(entry));
+    entry.opcode = IORING_OP_WRITE;
+    entry.fd = m_file_descriptor;
+    entry.addr = reinterpret_cast<uintptr_t>(response.data);
+    entry.len = static_cast<uint32_t>(response.num_bytes);
+    entry.off = static_cast<uint64_t>(m_file_offset);
+    entry.user_data = response.token;
+
+    m_submission_array[index] = index;
+
+    // Release, so that the kernel sees the complete entry.
+    __atomic_store_n(m_submission_tail, tail + 1, __ATOMIC_RELEASE);
+
+    ++m_num_entries_to_submit;
+    ++m_num_writes_in_flight;
+    m_file_offset += static_cast<off_t>(response.num_bytes);
+  }
+
+  return enter(0);
+}
+
+bool FileRecorder::poll_and_wait() {
+  if (!poll()) {
+    return false;
+  }
+
+  // Either the queue is full, or there is no more data right now.
+  if (m_num_writes_in_flight > 0) {
+    reap_completions(1);
+  }
+
+  return m_error == 0;
+}
+
+bool FileRecorder::finish() {
+  if (!is_valid()) {
+    return false;
+  }
+
+  while (m_num_writes_in_flight > 0) {
+    if (!reap_completions(1)) {
+      // The wait itself failed, so give up instead of spinning.
+      break;
+    }
+  }
+
+  return m_error == 0;
+}
+
+} // namespace dma_axi_write_simple
+
+} // namespace fpga
@@ -0,0 +1,58 @@
+// -------------------------------------------------------------------------------------------------
+// Copyright (c) Lukas Vik. All rights reserved.
+//
+// This file is part of the hdl-modules project, a collection of reusable, high-quality,
+// peer-reviewed VHDL building blocks.
+// https://hdl-modules.com
+// https://github.com/hdl-modules/hdl-modules
+// -------------------------------------------------------------------------------------------------
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "include/dma_axi_write_simple_mirrored_buffer.h"
+
+namespace fpga {
+
+namespace dma_axi_write_simple {
+
+MirroredBuffer::MirroredBuffer(int file_descriptor, off_t offset,
+                               size_t buffer_size_bytes)
+    : m_buffer_size_bytes(buffer_size_bytes) {
+  const size_t page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  if (buffer_size_bytes == 0 || buffer_size_bytes % page_size != 0) {
+    return;
+  }
+
+  // Reserve a virtual address range that can hold two copies, so that we know
+  // the two mappings below will end up next to each other.
+  void *reserved = mmap(nullptr, 2 * buffer_size_bytes, PROT_NONE,
+                        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (reserved == MAP_FAILED) {
+    return;
+  }
+
+  uint8_t *data = static_cast<uint8_t *>(reserved);
+
+  for (size_t mapping_index = 0; mapping_index < 2; ++mapping_index) {
+    void *mapping = mmap(data + mapping_index * buffer_size_bytes,
+                         buffer_size_bytes, PROT_READ | PROT_WRITE,
+                         MAP_SHARED | MAP_FIXED, file_descriptor, offset);
+    if (mapping == MAP_FAILED) {
+      munmap(reserved, 2 * buffer_size_bytes);
+      return;
+    }
+  }
+
+  m_data = data;
+}
+
+MirroredBuffer::~MirroredBuffer() {
+  if (m_data != nullptr) {
+    munmap(m_data, 2 * m_buffer_size_bytes);
+  }
+}
+
+} // namespace dma_axi_write_simple
+
+} // namespace fpga
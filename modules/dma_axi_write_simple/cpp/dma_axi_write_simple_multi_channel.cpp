@@ -0,0 +1,98 @@
+// -------------------------------------------------------------------------------------------------
+// Copyright (c) Lukas Vik. All rights reserved.
+//
+// This file is part of the hdl-modules project, a collection of reusable, high-quality,
+// peer-reviewed VHDL building blocks.
+// https://hdl-modules.com
+// https://github.com/hdl-modules/hdl-modules
+// -------------------------------------------------------------------------------------------------
+
+#include "include/dma_axi_write_simple_multi_channel.h"
+
+#include "../../common/cpp/common_dma_assert.h"
+
+namespace fpga {
+
+namespace dma_axi_write_simple {
+
+// Register indexes in the summary bank of the FPGA module.
+static const size_t channel_interrupts_register_index =
+    fpga_regs::dma_axi_write_simple::summary_channel_interrupts_index;
+static const size_t first_written_address_register_index =
+    fpga_regs::dma_axi_write_simple::summary_first_written_address_index;
+
+DmaMultiChannel::DmaMultiChannel(uintptr_t register_base_address,
+                                 size_t num_channels,
+                                 bool (*assertion_handler)(const std::string *))
+    : m_summary_registers(
+          reinterpret_cast<volatile uint32_t *>(register_base_address)),
+      m_num_channels(num_channels), m_assertion_handler(assertion_handler) {
+  const bool num_channels_is_valid =
+      num_channels > 0 && num_channels <= max_num_channels;
+  _DMA_ASSERT_TRUE(num_channels_is_valid, invalid_num_channels, 0,
+                   num_channels,
+                   "Invalid number of channels: " << num_channels);
+
+  if (!num_channels_is_valid) {
+    m_num_channels = 0;
+  }
+}
+
+void DmaMultiChannel::set_error_handler(
+    bool (*error_handler)(const Error *)) {
+  m_error_handler = error_handler;
+}
+
+bool DmaMultiChannel::check_channel(size_t channel) {
+  _DMA_ASSERT_TRUE(channel < m_num_channels, invalid_channel, 0, channel,
+                   "Invalid channel index: " << channel);
+
+  return channel < m_num_channels;
+}
+
+void DmaMultiChannel::set_channel(size_t channel, DmaNoCopy *dma) {
+  if (!check_channel(channel)) {
+    return;
+  }
+
+  m_channels[channel] = dma;
+
+  if (dma != nullptr) {
+    dma->set_written_address_caching(true);
+  }
+}
+
+uint32_t DmaMultiChannel::get_channel_interrupts() {
+  return m_summary_registers[channel_interrupts_register_index];
+}
+
+uint32_t DmaMultiChannel::read_summary(uint32_t *written_addresses) {
+  const uint32_t channel_interrupts =
+      m_summary_registers[channel_interrupts_register_index];
+
+  // Read in address order, which is the access pattern that bus bridges with
+  // prefetching handle best.
+  for (size_t channel = 0; channel < m_num_channels; ++channel) {
+    written_addresses[channel] =
+        m_summary_registers[first_written_address_register_index + channel];
+  }
+
+  return channel_interrupts;
+}
+
+uint32_t DmaMultiChannel::update() {
+  uint32_t written_addresses[max_num_channels];
+  const uint32_t channel_interrupts = read_summary(written_addresses);
+
+  for (size_t channel = 0; channel < m_num_channels; ++channel) {
+    if (m_channels[channel] != nullptr) {
+      m_channels[channel]->set_written_address(written_addresses[channel]);
+    }
+  }
+
+  return channel_interrupts;
+}
+
+} // namespace dma_axi_write_simple
+
+} // namespace fpga
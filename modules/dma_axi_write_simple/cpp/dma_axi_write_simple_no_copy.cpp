@@ -7,76 +7,564 @@
 // https://github.com/hdl-modules/hdl-modules
 // -------------------------------------------------------------------------------------------------
 
+#include <cstring>
+
+#ifdef DMA_LATENCY_HISTOGRAM
+#include <chrono>
+#endif
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 #include "include/dma_axi_write_simple_no_copy.h"
+#include "include/dma_axi_write_simple_mirrored_buffer.h"
+
+#include "../../common/cpp/common_dma_assert.h"
 
 namespace fpga {
 
 namespace dma_axi_write_simple {
 
-#ifdef NO_DMA_ASSERT
-
-#define _DMA_ASSERT_TRUE(expression, message) ((void)0)
+#ifdef DMA_STATISTICS
 
-#else // Not NO_DMA_ASSERT.
+// Add to a statistics counter.
+// Each counter has only one writer, so a read-modify-write is not necessary.
+#define _DMA_COUNT(counter, num)                                               \
+  m_statistics.counter.store(                                                  \
+      m_statistics.counter.load(std::memory_order_relaxed) + (num),            \
+      std::memory_order_relaxed)
 
-// This macro is called by the DMA code to check for runtime errors.
-#define _DMA_ASSERT_TRUE(expression, message)                                  \
-  {                                                                            \
-    if (!static_cast<bool>(expression)) {                                      \
-      std::ostringstream diagnostics;                                          \
-      diagnostics << "DMA error occurred in " << __FILE__ << ":" << __LINE__   \
-                  << ", message: " << message << ".";                          \
-      std::string diagnostic_message = diagnostics.str();                      \
-      m_assertion_handler(&diagnostic_message);                                \
-    }                                                                          \
+// Update a statistics counter with a new value if it is greater.
+#define _DMA_COUNT_MAX(counter, value)                                         \
+  if ((value) > m_statistics.counter.load(std::memory_order_relaxed)) {        \
+    m_statistics.counter.store((value), std::memory_order_relaxed);            \
   }
 
-#endif // NO_DMA_ASSERT.
+#else // Not DMA_STATISTICS.
+
+#define _DMA_COUNT(counter, num) ((void)0)
+#define _DMA_COUNT_MAX(counter, value) ((void)0)
+
+#endif // DMA_STATISTICS.
+
+#ifdef DMA_LATENCY_HISTOGRAM
+
+// Call a latency tracking method.
+#define _DMA_TRACK_LATENCY(call) call
+
+#else // Not DMA_LATENCY_HISTOGRAM.
+
+#define _DMA_TRACK_LATENCY(call) ((void)0)
+
+#endif // DMA_LATENCY_HISTOGRAM.
 
 DmaNoCopy::DmaNoCopy(uintptr_t register_base_address, void *buffer,
                      size_t buffer_size_bytes,
                      bool (*assertion_handler)(const std::string *))
+    : DmaNoCopy(register_base_address, reinterpret_cast<uintptr_t>(buffer),
+                buffer, buffer_size_bytes, assertion_handler) {}
+
+DmaNoCopy::DmaNoCopy(uintptr_t register_base_address,
+                     uint64_t buffer_physical_address, void *buffer,
+                     size_t buffer_size_bytes,
+                     bool (*assertion_handler)(const std::string *))
+    : DmaNoCopy(register_base_address, nullptr, buffer_physical_address, buffer,
+                buffer_size_bytes, assertion_handler) {}
+
+DmaNoCopy::DmaNoCopy(fpga_regs::IDmaAxiWriteSimple *register_interface,
+                     uint64_t buffer_physical_address, void *buffer,
+                     size_t buffer_size_bytes,
+                     bool (*assertion_handler)(const std::string *))
+    : DmaNoCopy(0, register_interface, buffer_physical_address, buffer,
+                buffer_size_bytes, assertion_handler) {}
+
+DmaNoCopy::DmaNoCopy(uintptr_t register_base_address,
+                     fpga_regs::IDmaAxiWriteSimple *register_interface,
+                     uint64_t buffer_physical_address, void *buffer,
+                     size_t buffer_size_bytes,
+                     bool (*assertion_handler)(const std::string *))
     : m_buffer(reinterpret_cast<volatile uint8_t *>(buffer)),
       m_buffer_size_bytes(buffer_size_bytes),
       m_assertion_handler(assertion_handler),
-      registers(fpga_regs::DmaAxiWriteSimple(register_base_address,
-                                               assertion_handler)) {
-  uintptr_t start_address = reinterpret_cast<uintptr_t>(m_buffer);
-  uintptr_t end_address = start_address + m_buffer_size_bytes;
+      m_start_address(buffer_physical_address),
+      m_end_address(buffer_physical_address + buffer_size_bytes),
+      m_own_registers(
+          register_interface == nullptr
+              ? std::optional<fpga_regs::DmaAxiWriteSimple>(
+                    std::in_place, register_base_address, assertion_handler)
+              : std::nullopt),
+      registers(register_interface == nullptr ? *m_own_registers
+                                              : *register_interface) {
+  // All address calculations in this class are done on the lower 32 bits.
+  // The upper bits are only written once, when setting up the module.
+  _DMA_ASSERT_TRUE((m_start_address >> 32) == ((m_end_address - 1) >> 32),
+                   buffer_crosses_address_boundary, 0, m_start_address,
+                   "Buffer must not cross a 4 GiB address boundary");
+}
+
+DmaNoCopy::DmaNoCopy(uintptr_t register_base_address,
+                     uint64_t buffer_physical_address,
+                     const MirroredBuffer &buffer,
+                     bool (*assertion_handler)(const std::string *))
+    : DmaNoCopy(register_base_address, buffer_physical_address,
+                buffer.get_data(), buffer.get_buffer_size_bytes(),
+                assertion_handler) {
+  m_buffer_is_mirrored = true;
 
-  // FPGA registers are 32 bit.
-  // Cast here, if 'uintptr_t' is wider than 32 bits on the platform we are
-  // compiling for, this should give a compiler error.
-  m_start_address = static_cast<uint32_t>(start_address);
-  m_end_address = static_cast<uint32_t>(end_address);
+  _DMA_ASSERT_TRUE(buffer.is_valid(), invalid_mirrored_buffer, 0, 0,
+                   "Got invalid mirrored buffer");
+}
+
+void DmaNoCopy::set_error_handler(bool (*error_handler)(const Error *)) {
+  m_error_handler = error_handler;
 }
 
 void DmaNoCopy::setup_and_enable() {
-  _DMA_ASSERT_TRUE(!registers.get_config_enable(),
+  _DMA_ASSERT_TRUE(!registers.get_config_enable(), already_enabled, 0, 0,
                    "Tried to enable DMA that is already running");
 
-  registers.set_buffer_start_address(m_start_address);
-  registers.set_buffer_end_address(m_end_address);
-  registers.set_buffer_read_address(m_start_address);
+  // The '_high' registers are only present if the 'address_width' generic of
+  // the FPGA module is greater than 32.
+  // Their default value is zero, so they only need to be written if the buffer
+  // is above 4 GiB.
+  if ((m_end_address >> 32) != 0) {
+    registers.set_buffer_start_address_high(
+        static_cast<uint32_t>(m_start_address >> 32));
+    registers.set_buffer_end_address_high(
+        static_cast<uint32_t>(m_end_address >> 32));
+    registers.set_buffer_read_address_high(
+        static_cast<uint32_t>(m_start_address >> 32));
+  }
+
+  registers.set_buffer_start_address(static_cast<uint32_t>(m_start_address));
+  registers.set_buffer_end_address(static_cast<uint32_t>(m_end_address));
+  registers.set_buffer_read_address(static_cast<uint32_t>(m_start_address));
+
+  if (m_writeback_location != nullptr) {
+    // The FPGA writes the location only after the first packet.
+    *const_cast<volatile uint64_t *>(m_writeback_location) =
+        static_cast<uint32_t>(m_start_address);
+    m_writeback_sequence_number = 0;
+  }
 
   registers.set_config_enable(1);
 }
 
+void DmaNoCopy::set_flush_timeout(uint32_t num_clock_cycles) {
+  registers.set_flush_timeout_cycles(num_clock_cycles);
+}
+
 Response DmaNoCopy::receive_all_data() {
   return receive_data(1, m_buffer_size_bytes);
 }
 
 Response DmaNoCopy::receive_data(size_t min_num_bytes, size_t max_num_bytes) {
-  check_status();
+  return receive_data(0, min_num_bytes, max_num_bytes);
+}
+
+Response DmaNoCopy::receive_data(size_t reader, size_t min_num_bytes,
+                                 size_t max_num_bytes) {
+  _DMA_ASSERT_TRUE(reader < m_num_readers, invalid_reader, 0, reader,
+                   "Invalid reader: " << reader);
+
+  volatile void *result_data =
+      &m_buffer[m_readers[reader].in_buffer_read_outstanding_address.load(
+          std::memory_order_relaxed)];
+
+  const size_t result_num_bytes =
+      receive(reader, min_num_bytes, max_num_bytes, m_buffer_is_mirrored);
+  if (result_num_bytes == 0) {
+    return response_zero_bytes;
+  }
+
+  return {result_num_bytes, result_data};
+}
+
+TokenResponse DmaNoCopy::receive_data_token(size_t min_num_bytes,
+                                            size_t max_num_bytes) {
+  _DMA_ASSERT_TRUE(!m_enable_concurrent_mode, tokens_in_concurrent_mode, 0, 0,
+                   "Tokens can not be used in concurrent mode");
+
+  collect_released_tokens();
+
+  if (m_num_tokens_outstanding == max_num_tokens) {
+    return {0, nullptr, 0};
+  }
+
+  const Response response = receive_data(0, min_num_bytes, max_num_bytes);
+  if (response.num_bytes == 0) {
+    return {0, nullptr, 0};
+  }
+
+  const size_t token =
+      (m_oldest_token + m_num_tokens_outstanding) % max_num_tokens;
+  m_token_num_bytes[token] = static_cast<uint32_t>(response.num_bytes);
+  ++m_num_tokens_outstanding;
+  // Only written by this thread, so no read-modify-write is needed.
+  m_outstanding_tokens_mask.store(
+      m_outstanding_tokens_mask.load(std::memory_order_relaxed) |
+          (uint64_t(1) << token),
+      std::memory_order_relaxed);
+
+  return {response.num_bytes, response.data, token};
+}
+
+void DmaNoCopy::release_token(size_t token) {
+  _DMA_ASSERT_TRUE(token < max_num_tokens, invalid_token, 0, token,
+                   "Invalid token: " << token);
+
+  const uint64_t token_mask = uint64_t(1) << token;
+
+  // The outstanding window, from 'm_oldest_token' and onwards, as a mask.
+  // Since those members are not atomic, they can not be read here.
+  _DMA_ASSERT_TRUE(
+      (m_outstanding_tokens_mask.load(std::memory_order_relaxed) &
+       token_mask) != 0,
+      invalid_token, 0, token, "Token is not outstanding: " << token);
+
+  // Release, so that the worker is done with the data before the buffer space
+  // can be given back to the FPGA.
+  [[maybe_unused]] const uint64_t previous_released_mask =
+      m_released_tokens_mask.fetch_or(token_mask, std::memory_order_release);
+
+  _DMA_ASSERT_TRUE((previous_released_mask & token_mask) == 0, invalid_token,
+                   0, token, "Token released twice: " << token);
+}
+
+size_t DmaNoCopy::collect_released_tokens() {
+  const uint64_t released_mask =
+      m_released_tokens_mask.load(std::memory_order_acquire);
+
+  // Collect from the oldest token and onwards, until we find one that is
+  // still outstanding.
+  uint64_t collected_mask = 0;
+  size_t num_bytes = 0;
+  while (m_num_tokens_outstanding > 0) {
+    const uint64_t token_mask = uint64_t(1) << m_oldest_token;
+    if ((released_mask & token_mask) == 0) {
+      break;
+    }
+
+    collected_mask |= token_mask;
+    num_bytes += m_token_num_bytes[m_oldest_token];
+
+    m_oldest_token = (m_oldest_token + 1) % max_num_tokens;
+    --m_num_tokens_outstanding;
+  }
+
+  if (collected_mask != 0) {
+    // Before the released bits are cleared, so that a token that is released
+    // again after this is reported as not outstanding.
+    m_outstanding_tokens_mask.store(
+        m_outstanding_tokens_mask.load(std::memory_order_relaxed) &
+            ~collected_mask,
+        std::memory_order_relaxed);
+
+    // Clear only the bits we collected, since other tokens might be released
+    // concurrently.
+    m_released_tokens_mask.fetch_and(~collected_mask,
+                                     std::memory_order_relaxed);
+    done_with_data(0, num_bytes);
+  }
+
+  return num_bytes;
+}
+
+IovResponse DmaNoCopy::receive_data_iov(size_t min_num_bytes,
+                                        size_t max_num_bytes) {
+  return receive_data_iov(0, min_num_bytes, max_num_bytes);
+}
+
+IovResponse DmaNoCopy::receive_data_iov(size_t reader, size_t min_num_bytes,
+                                        size_t max_num_bytes) {
+  _DMA_ASSERT_TRUE(reader < m_num_readers, invalid_reader, 0, reader,
+                   "Invalid reader: " << reader);
+
+  const size_t read_address =
+      m_readers[reader].in_buffer_read_outstanding_address.load(
+          std::memory_order_relaxed);
+
+  const size_t result_num_bytes =
+      receive(reader, min_num_bytes, max_num_bytes, true);
+
+  IovResponse result = {};
+  result.num_bytes = result_num_bytes;
+
+  if (result_num_bytes == 0) {
+    return result;
+  }
+
+  // Segments use the POSIX 'iovec' type, which does not have a 'volatile'
+  // qualifier.
+  uint8_t *buffer = const_cast<uint8_t *>(m_buffer);
+
+  const size_t num_bytes_until_end = m_buffer_size_bytes - read_address;
+  if (result_num_bytes <= num_bytes_until_end || m_buffer_is_mirrored) {
+    result.num_segments = 1;
+    result.segments[0].iov_base = &buffer[read_address];
+    result.segments[0].iov_len = result_num_bytes;
+  } else {
+    result.num_segments = 2;
+    result.segments[0].iov_base = &buffer[read_address];
+    result.segments[0].iov_len = num_bytes_until_end;
+    result.segments[1].iov_base = &buffer[0];
+    result.segments[1].iov_len = result_num_bytes - num_bytes_until_end;
+  }
+
+  return result;
+}
+
+void DmaNoCopy::set_cache_invalidate_function(
+    void (*invalidate_function)(const void *, size_t)) {
+  m_cache_invalidate_function = invalidate_function;
+}
+
+CacheableResponse DmaNoCopy::receive_data_cacheable(size_t min_num_bytes,
+                                                    size_t max_num_bytes) {
+  return receive_data_cacheable(0, min_num_bytes, max_num_bytes);
+}
+
+CacheableResponse DmaNoCopy::receive_data_cacheable(size_t reader,
+                                                    size_t min_num_bytes,
+                                                    size_t max_num_bytes) {
+  _DMA_ASSERT_TRUE(reader < m_num_readers, invalid_reader, 0, reader,
+                   "Invalid reader: " << reader);
 
-  size_t written_address = registers.get_buffer_written_address();
   const size_t read_address =
-      m_start_address + m_in_buffer_read_outstanding_address;
+      m_readers[reader].in_buffer_read_outstanding_address.load(
+          std::memory_order_relaxed);
+  const uint8_t *result_data =
+      const_cast<const uint8_t *>(&m_buffer[read_address]);
+
+  const size_t result_num_bytes =
+      receive(reader, min_num_bytes, max_num_bytes, m_buffer_is_mirrored);
+  if (result_num_bytes == 0) {
+    return {0, nullptr};
+  }
+
+  return {result_num_bytes, result_data};
+}
+
+PacketView DmaNoCopy::receive_packets(size_t packet_length_bytes,
+                                     size_t min_num_packets,
+                                     size_t max_num_packets) {
+  return receive_packets(0, packet_length_bytes, min_num_packets,
+                         max_num_packets);
+}
+
+PacketView DmaNoCopy::receive_packets(size_t reader, size_t packet_length_bytes,
+                                     size_t min_num_packets,
+                                     size_t max_num_packets) {
+  // The buffer start and size must be aligned with the packet length used by
+  // the FPGA, so the given value must be as well, if it is correct.
+  _DMA_ASSERT_TRUE(packet_length_bytes > 0 &&
+                       m_buffer_size_bytes % packet_length_bytes == 0 &&
+                       m_start_address % packet_length_bytes == 0,
+                   invalid_packet_length, 0, packet_length_bytes,
+                   "Invalid packet length: " << packet_length_bytes);
+  if (packet_length_bytes == 0) {
+    return PacketView();
+  }
+
+  // Clamp before multiplying, so that e.g. a 'SIZE_MAX' argument does not
+  // overflow.
+  // The buffer can never hold this many packets, so a minimum that is clamped
+  // is still never reached.
+  const size_t max_num_packets_in_buffer =
+      m_buffer_size_bytes / packet_length_bytes;
+  const size_t min_num_bytes =
+      std::min(min_num_packets, max_num_packets_in_buffer) *
+      packet_length_bytes;
+  const size_t max_num_bytes =
+      std::min(max_num_packets, max_num_packets_in_buffer) *
+      packet_length_bytes;
+
+  const CacheableResponse response =
+      receive_data_cacheable(reader, min_num_bytes, max_num_bytes);
+
+  // Would happen if the given packet length is longer than the one used by
+  // the FPGA.
+  // The view would then leave out a partial packet at the end, that would
+  // never be marked as done.
+  _DMA_ASSERT_TRUE(response.num_bytes % packet_length_bytes == 0,
+                   invalid_packet_length, 0, packet_length_bytes,
+                   "Received data is not a whole number of packets of "
+                       << packet_length_bytes << " bytes");
+
+  return PacketView(response.data, response.num_bytes, packet_length_bytes);
+}
+
+#if defined(__aarch64__)
+// Copy using only naturally aligned loads from the source.
+// The memory buffer is mapped as device memory if it is uncached, where an
+// unaligned access faults.
+// Note that 'memcpy' may use unaligned loads, so it can not be used.
+// The loads are volatile, so that the compiler does not replace the loop with
+// a call to 'memcpy'.
+static void copy_aligned_loads(uint8_t *destination, const uint8_t *source,
+                               size_t num_bytes) {
+  while (num_bytes > 0 && (reinterpret_cast<uintptr_t>(source) & 7) != 0) {
+    *destination++ = *reinterpret_cast<const volatile uint8_t *>(source++);
+    --num_bytes;
+  }
+
+  while (num_bytes >= 8) {
+    const uint64_t word =
+        *reinterpret_cast<const volatile uint64_t *>(source);
+    std::memcpy(destination, &word, 8);
+    destination += 8;
+    source += 8;
+    num_bytes -= 8;
+  }
+
+  while (num_bytes > 0) {
+    *destination++ = *reinterpret_cast<const volatile uint8_t *>(source++);
+    --num_bytes;
+  }
+}
+#endif
+
+// Copy with non-temporal stores where available, which bypass the data cache.
+static void copy_non_temporal(uint8_t *destination, const uint8_t *source,
+                              size_t num_bytes) {
+#if defined(__SSE2__)
+  // Copy the first bytes normally, so that the vector stores are aligned.
+  const size_t num_bytes_head = std::min(
+      num_bytes, (16 - (reinterpret_cast<uintptr_t>(destination) & 15)) & 15);
+  std::memcpy(destination, source, num_bytes_head);
+  destination += num_bytes_head;
+  source += num_bytes_head;
+  num_bytes -= num_bytes_head;
+
+  while (num_bytes >= 32) {
+    const __m128i low =
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(source));
+    const __m128i high =
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(source + 16));
+    _mm_stream_si128(reinterpret_cast<__m128i *>(destination), low);
+    _mm_stream_si128(reinterpret_cast<__m128i *>(destination + 16), high);
+    destination += 32;
+    source += 32;
+    num_bytes -= 32;
+  }
 
-  const size_t num_bytes_available =
-      (written_address - read_address) % m_buffer_size_bytes;
+  // Non-temporal stores are weakly ordered.
+  // Make sure they are visible before the data is handed to another thread.
+  _mm_sfence();
+
+  std::memcpy(destination, source, num_bytes);
+
+#elif defined(__aarch64__)
+  // The source might be device memory, see 'copy_aligned_loads'.
+  // Align the source, so that the vector loads are aligned.
+  // The destination is normal memory, where the stores need no alignment.
+  const size_t num_bytes_head = std::min(
+      num_bytes, (16 - (reinterpret_cast<uintptr_t>(source) & 15)) & 15);
+  copy_aligned_loads(destination, source, num_bytes_head);
+  destination += num_bytes_head;
+  source += num_bytes_head;
+  num_bytes -= num_bytes_head;
+
+  while (num_bytes >= 32) {
+    asm volatile("ldp q0, q1, [%1]\n\t"
+                 "stnp q0, q1, [%0]"
+                 :
+                 : "r"(destination), "r"(source)
+                 : "v0", "v1", "memory");
+    destination += 32;
+    source += 32;
+    num_bytes -= 32;
+  }
+
+  copy_aligned_loads(destination, source, num_bytes);
+
+#else
+  // Assumes that the memory buffer is normal memory, where 'memcpy' is safe.
+  std::memcpy(destination, source, num_bytes);
+#endif
+}
+
+size_t DmaNoCopy::receive_into(void *destination, size_t min_num_bytes,
+                               size_t max_num_bytes) {
+  return receive_into(0, destination, min_num_bytes, max_num_bytes);
+}
+
+size_t DmaNoCopy::receive_into(size_t reader, void *destination,
+                               size_t min_num_bytes, size_t max_num_bytes) {
+  _DMA_ASSERT_TRUE(!m_enable_concurrent_mode, copy_in_concurrent_mode, 0, 0,
+                   "Copying receive can not be used in concurrent mode");
+  _DMA_ASSERT_TRUE(reader < m_num_readers, invalid_reader, 0, reader,
+                   "Invalid reader: " << reader);
+
+  // The copied data is marked as done below, which marks the oldest
+  // outstanding data of the reader.
+  // So there must be no other data outstanding, or the wrong region would be
+  // released to the FPGA.
+  [[maybe_unused]] const ReadCursor &cursor = m_readers[reader];
+  _DMA_ASSERT_TRUE(cursor.in_buffer_read_done_address ==
+                       cursor.in_buffer_read_outstanding_address.load(
+                           std::memory_order_relaxed),
+                   data_outstanding_before_copy, 0, reader,
+                   "Can not copy data for a reader that has outstanding data: "
+                       << reader);
+
+  const IovResponse response =
+      receive_data_iov(reader, min_num_bytes, max_num_bytes);
+
+  uint8_t *result = static_cast<uint8_t *>(destination);
+  for (size_t segment_index = 0; segment_index < response.num_segments;
+       ++segment_index) {
+    const Segment &segment = response.segments[segment_index];
+
+    copy_non_temporal(result, static_cast<const uint8_t *>(segment.iov_base),
+                      segment.iov_len);
+    result += segment.iov_len;
+  }
+
+  // Release the buffer space right away, since we have our own copy.
+  done_with_data(reader, response.num_bytes);
+
+  return response.num_bytes;
+}
+
+size_t DmaNoCopy::receive(size_t reader, size_t min_num_bytes,
+                          size_t max_num_bytes, bool allow_wrap) {
+  ReadCursor &cursor = m_readers[reader];
+  // Only this thread writes the value, so no synchronization needed for
+  // reading it.
+  const uint32_t read_outstanding_address =
+      cursor.in_buffer_read_outstanding_address.load(std::memory_order_relaxed);
+
+  if (!m_enable_written_address_caching ||
+      get_num_bytes_available_cached(reader) < min_num_bytes) {
+    // With writeback, the interrupt status is read only on every so many
+    // calls, so that most polls do not access any register.
+    // Error interrupts are still detected, with a bounded delay.
+    if (m_writeback_location == nullptr ||
+        ++m_num_receives_since_status_check >=
+            num_receives_per_writeback_status_check) {
+      check_status();
+    }
+    update_written_address();
+  }
+
+  const size_t num_bytes_available = get_num_bytes_available_cached(reader);
+
+  _DMA_COUNT(num_receive_calls, 1);
+  _DMA_COUNT_MAX(max_num_bytes_available, num_bytes_available);
 
   if (num_bytes_available < min_num_bytes) {
+    // The FPGA might be stalling, waiting for buffer space that we are holding
+    // back.
+    // In concurrent mode, the 'done' thread owns the release state and takes
+    // care of this instead.
+    if (!m_enable_concurrent_mode) {
+      flush_release();
+    }
+
+    _DMA_COUNT(num_empty_receives, 1);
+
     // Note that 'num_bytes_available' can be zero sometimes even if we got
     // the 'write_done' interrupt, depending on the timing of things.
     // If in the previous round we got and cleared the interrupt,
@@ -84,7 +572,7 @@ Response DmaNoCopy::receive_data(size_t min_num_bytes, size_t max_num_bytes) {
     // In that case we would read and process all the data, but the interrupt
     // would still have triggered again and triggered another entry into this
     // function.
-    return response_zero_bytes;
+    return 0;
   }
 
   // Maximum, given how much is available in the buffer, and the
@@ -94,62 +582,561 @@ Response DmaNoCopy::receive_data(size_t min_num_bytes, size_t max_num_bytes) {
 
   size_t result_num_bytes = 0;
 
-  if (written_address < read_address) {
+  if (m_in_buffer_written_address < read_outstanding_address && !allow_wrap) {
     // Read at most up until the end.
     // Might result in smaller chunks than 'min_num_bytes'.
     // But we have to do that since the result buffer must be continuous.
     // An alternative would be to copy data into a longer buffer.
-    const size_t num_bytes_until_end = m_end_address - read_address;
+    const size_t num_bytes_until_end =
+        m_buffer_size_bytes - read_outstanding_address;
     result_num_bytes = std::min(max_num_bytes_to_read_out, num_bytes_until_end);
+
+    if (result_num_bytes < max_num_bytes_to_read_out) {
+      _DMA_COUNT(num_wrapped_short_receives, 1);
+    }
   } else {
     // Read as much data as we can.
-    // We have guaranteed 'max_num_bytes_to_read_out' of continuous data.
+    // We have guaranteed 'max_num_bytes_to_read_out' of data.
+    // Either because it does not wrap, or because the caller can handle data
+    // that wraps (mirrored buffer or segmented response).
     result_num_bytes = max_num_bytes_to_read_out;
   }
 
-  volatile void *result_data = &m_buffer[m_in_buffer_read_outstanding_address];
+  _DMA_COUNT(num_bytes_received, result_num_bytes);
 
-  m_in_buffer_read_outstanding_address =
-      (m_in_buffer_read_outstanding_address + result_num_bytes) %
-      m_buffer_size_bytes;
+  invalidate_cache(read_outstanding_address, result_num_bytes);
 
-  return {result_num_bytes, result_data};
+  _DMA_TRACK_LATENCY(
+      track_received(reader, read_outstanding_address, result_num_bytes));
+
+  // Release, so that the cache invalidation is complete before the 'done'
+  // thread can see the new value.
+  cursor.in_buffer_read_outstanding_address.store(
+      wrap_address(read_outstanding_address + result_num_bytes),
+      std::memory_order_release);
+
+  return result_num_bytes;
+}
+
+void DmaNoCopy::invalidate_cache(size_t in_buffer_address,
+                                 size_t num_bytes) const {
+  if (m_cache_invalidate_function == nullptr) {
+    return;
+  }
+
+  const uint8_t *buffer = const_cast<const uint8_t *>(m_buffer);
+
+  const size_t num_bytes_until_end = m_buffer_size_bytes - in_buffer_address;
+  if (num_bytes <= num_bytes_until_end || m_buffer_is_mirrored) {
+    m_cache_invalidate_function(&buffer[in_buffer_address], num_bytes);
+  } else {
+    m_cache_invalidate_function(&buffer[in_buffer_address],
+                                num_bytes_until_end);
+    m_cache_invalidate_function(&buffer[0], num_bytes - num_bytes_until_end);
+  }
+}
+
+void DmaNoCopy::set_written_address_caching(bool enable) {
+  m_enable_written_address_caching = enable;
+}
+
+void DmaNoCopy::set_written_address(uint32_t written_address) {
+  m_in_buffer_written_address =
+      written_address - static_cast<uint32_t>(m_start_address);
+  _DMA_TRACK_LATENCY(track_written());
+}
+
+void DmaNoCopy::set_written_address_writeback(
+    volatile void *location, uint64_t location_physical_address) {
+  _DMA_ASSERT_TRUE(!registers.get_config_enable(), already_enabled, 0, 0,
+                   "Must set up writeback before enabling DMA");
+
+  m_writeback_location = reinterpret_cast<volatile const uint64_t *>(location);
+
+  // Present only if the 'address_width' generic is greater than 32, see
+  // DmaNoCopy::setup_and_enable.
+  if ((location_physical_address >> 32) != 0) {
+    registers.set_writeback_address_high(
+        static_cast<uint32_t>(location_physical_address >> 32));
+  }
+  registers.set_writeback_address(
+      static_cast<uint32_t>(location_physical_address));
+  registers.set_writeback_config_enable(1);
+}
+
+void DmaNoCopy::set_interrupt_wait_function(
+    bool (*wait_function)(void *, uint32_t), void *context) {
+  m_interrupt_wait_function = wait_function;
+  m_interrupt_wait_context = context;
+
+  enable_write_done_interrupt();
+}
+
+void DmaNoCopy::enable_write_done_interrupt() {
+  registers.set_interrupt_mask(
+      registers.get_interrupt_mask() |
+      fpga_regs::dma_axi_write_simple::interrupt_status::write_done::
+          mask_shifted);
+}
+
+void DmaNoCopy::set_interrupt_coalescing(uint32_t num_packets,
+                                         uint32_t timeout_cycles) {
+  registers.set_interrupt_coalescing_packets(num_packets);
+  registers.set_interrupt_coalescing_timeout_cycles(timeout_cycles);
+}
+
+Response DmaNoCopy::wait_for_data(size_t min_num_bytes, size_t max_num_bytes,
+                                  uint32_t timeout_us) {
+  return wait_for_data(0, min_num_bytes, max_num_bytes, timeout_us);
+}
+
+Response DmaNoCopy::wait_for_data(size_t reader, size_t min_num_bytes,
+                                  size_t max_num_bytes, uint32_t timeout_us) {
+  _DMA_ASSERT_TRUE(m_interrupt_wait_function != nullptr,
+                   no_interrupt_wait_function, 0, 0,
+                   "Must set interrupt wait function before waiting for data");
+
+  while (true) {
+    const Response response =
+        receive_data_before_wait(reader, min_num_bytes, max_num_bytes);
+    if (response.num_bytes > 0) {
+      return response;
+    }
+
+    if (!m_interrupt_wait_function(m_interrupt_wait_context, timeout_us)) {
+      return response_zero_bytes;
+    }
+  }
+}
+
+Response DmaNoCopy::receive_data_before_wait(size_t min_num_bytes,
+                                             size_t max_num_bytes) {
+  return receive_data_before_wait(0, min_num_bytes, max_num_bytes);
+}
+
+Response DmaNoCopy::receive_data_before_wait(size_t reader,
+                                             size_t min_num_bytes,
+                                             size_t max_num_bytes) {
+  // Note that without writeback, this clears any pending interrupt status
+  // before reading the 'written_address'.
+  // Hence, if a packet is written after that point, the interrupt will
+  // trigger again, and a wait after this call will not miss it.
+  const Response response = receive_data(reader, min_num_bytes, max_num_bytes);
+  if (response.num_bytes > 0 || m_writeback_location == nullptr) {
+    return response;
+  }
+
+  // With writeback, the receive calls do not touch the interrupt status.
+  // So clear it here, and then read the memory location again.
+  // The FPGA triggers the interrupt only once the location has been written,
+  // so a value that lands after the read below will trigger it again.
+  check_status();
+
+  return receive_data(reader, min_num_bytes, max_num_bytes);
 }
 
 void DmaNoCopy::done_with_data(size_t num_bytes) {
+  done_with_data(0, num_bytes);
+}
+
+void DmaNoCopy::done_with_data(size_t reader, size_t num_bytes) {
+  _DMA_ASSERT_TRUE(reader < m_num_readers, invalid_reader, 0, reader,
+                   "Invalid reader: " << reader);
+
   if (num_bytes > 0) {
-    m_in_buffer_read_done_address =
-        (m_in_buffer_read_done_address + num_bytes) % m_buffer_size_bytes;
-    registers.set_buffer_read_address(m_start_address +
-                                        m_in_buffer_read_done_address);
+    ReadCursor &cursor = m_readers[reader];
+    cursor.in_buffer_read_done_address =
+        wrap_address(cursor.in_buffer_read_done_address + num_bytes);
+
+    m_in_buffer_read_done_address = get_oldest_done_address();
+
+    _DMA_TRACK_LATENCY(track_done(reader));
+
+    const size_t num_bytes_pending = get_distance(
+        m_in_buffer_read_released_address, m_in_buffer_read_done_address);
+    if (num_bytes_pending >= m_release_threshold_bytes ||
+        (m_enable_concurrent_mode && is_all_received_data_done())) {
+      flush_release();
+    }
+  }
+}
+
+void DmaNoCopy::set_release_threshold(size_t num_bytes) {
+  m_release_threshold_bytes = num_bytes;
+}
+
+void DmaNoCopy::flush_release() {
+  if (m_in_buffer_read_released_address != m_in_buffer_read_done_address) {
+    registers.set_buffer_read_address(
+        static_cast<uint32_t>(m_start_address) + m_in_buffer_read_done_address);
+    m_in_buffer_read_released_address = m_in_buffer_read_done_address;
+
+    _DMA_COUNT(num_read_address_writes, 1);
+  }
+}
+
+Statistics DmaNoCopy::get_statistics() const {
+  Statistics result = {};
+
+#ifdef DMA_STATISTICS
+  result.num_receive_calls =
+      m_statistics.num_receive_calls.load(std::memory_order_relaxed);
+  result.num_empty_receives =
+      m_statistics.num_empty_receives.load(std::memory_order_relaxed);
+  result.num_wrapped_short_receives =
+      m_statistics.num_wrapped_short_receives.load(std::memory_order_relaxed);
+  result.num_bytes_received =
+      m_statistics.num_bytes_received.load(std::memory_order_relaxed);
+  result.max_num_bytes_available =
+      m_statistics.max_num_bytes_available.load(std::memory_order_relaxed);
+  result.num_error_interrupts =
+      m_statistics.num_error_interrupts.load(std::memory_order_relaxed);
+  result.num_read_address_writes =
+      m_statistics.num_read_address_writes.load(std::memory_order_relaxed);
+#endif
+
+  return result;
+}
+
+LatencyHistograms DmaNoCopy::get_latency_histograms() const {
+  LatencyHistograms result = {};
+
+#ifdef DMA_LATENCY_HISTOGRAM
+  for (size_t bucket = 0; bucket < LatencyHistogram::num_buckets; ++bucket) {
+    result.receive_latency.counts[bucket] =
+        m_receive_latency.counts[bucket].load(std::memory_order_relaxed);
+    result.hold_time.counts[bucket] =
+        m_hold_time.counts[bucket].load(std::memory_order_relaxed);
+  }
+  result.receive_latency.max =
+      m_receive_latency.max.load(std::memory_order_relaxed);
+  result.hold_time.max = m_hold_time.max.load(std::memory_order_relaxed);
+#endif
+
+  return result;
+}
+
+void DmaNoCopy::set_latency_clock_function(uint64_t (*clock_function)()) {
+#ifdef DMA_LATENCY_HISTOGRAM
+  m_latency_clock_function = clock_function;
+#else
+  (void)clock_function;
+#endif
+}
+
+#ifdef DMA_LATENCY_HISTOGRAM
+
+uint64_t DmaNoCopy::get_latency_time() const {
+  if (m_latency_clock_function != nullptr) {
+    return m_latency_clock_function();
+  }
+
+  return static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now().time_since_epoch())
+          .count());
+}
+
+void DmaNoCopy::record_latency(LatencyHistogramCounters &histogram,
+                               uint64_t latency) {
+  // The index of the most significant bit that is set.
+  const size_t msb_index =
+      latency == 0 ? 0 : static_cast<size_t>(63 - __builtin_clzll(latency));
+  const size_t bucket = std::min(msb_index, LatencyHistogram::num_buckets - 1);
+
+  // Only one writer, see the statistics counters.
+  std::atomic<uint64_t> &count = histogram.counts[bucket];
+  count.store(count.load(std::memory_order_relaxed) + 1,
+              std::memory_order_relaxed);
+
+  if (latency > histogram.max.load(std::memory_order_relaxed)) {
+    histogram.max.store(latency, std::memory_order_relaxed);
+  }
+}
+
+void DmaNoCopy::reset_timed_regions(TimedRegions &regions,
+                                    uint32_t in_buffer_address) {
+  regions.in_buffer_start_address = in_buffer_address;
+  regions.oldest = 0;
+  regions.num_regions = 0;
+}
+
+void DmaNoCopy::push_timed_region(TimedRegions &regions,
+                                  uint32_t in_buffer_end_address,
+                                  uint64_t time) {
+  if (regions.num_regions == max_num_timed_regions) {
+    const size_t newest = (regions.oldest + max_num_timed_regions - 1) %
+                          max_num_timed_regions;
+    regions.in_buffer_end_address[newest] = in_buffer_end_address;
+    return;
+  }
+
+  const size_t index =
+      (regions.oldest + regions.num_regions) % max_num_timed_regions;
+  regions.in_buffer_end_address[index] = in_buffer_end_address;
+  regions.time[index] = time;
+  ++regions.num_regions;
+}
+
+bool DmaNoCopy::pop_timed_region(TimedRegions &regions,
+                                 uint32_t in_buffer_address,
+                                 uint64_t *time) const {
+  if (regions.num_regions == 0) {
+    return false;
+  }
+
+  const uint32_t in_buffer_end_address =
+      regions.in_buffer_end_address[regions.oldest];
+  if (get_distance(regions.in_buffer_start_address, in_buffer_end_address) >
+      get_distance(regions.in_buffer_start_address, in_buffer_address)) {
+    return false;
+  }
+
+  *time = regions.time[regions.oldest];
+
+  regions.in_buffer_start_address = in_buffer_end_address;
+  regions.oldest = (regions.oldest + 1) % max_num_timed_regions;
+  --regions.num_regions;
+
+  return true;
+}
+
+void DmaNoCopy::track_written() {
+  if (m_enable_concurrent_mode) {
+    return;
+  }
+
+  const TimedRegions &regions = m_written_regions;
+  const uint32_t in_buffer_newest_end_address =
+      regions.num_regions == 0
+          ? regions.in_buffer_start_address
+          : regions.in_buffer_end_address[(regions.oldest +
+                                           regions.num_regions - 1) %
+                                          max_num_timed_regions];
+
+  if (m_in_buffer_written_address != in_buffer_newest_end_address) {
+    push_timed_region(m_written_regions, m_in_buffer_written_address,
+                      get_latency_time());
+  }
+}
+
+void DmaNoCopy::track_received(size_t reader, uint32_t in_buffer_address,
+                               size_t num_bytes) {
+  if (m_enable_concurrent_mode || num_bytes == 0) {
+    return;
+  }
+
+  const uint64_t now = get_latency_time();
+
+  // Find the written region that holds the first byte of the data.
+  const TimedRegions &written = m_written_regions;
+  const size_t offset =
+      get_distance(written.in_buffer_start_address, in_buffer_address);
+  for (size_t region = 0; region < written.num_regions; ++region) {
+    const size_t index = (written.oldest + region) % max_num_timed_regions;
+    if (get_distance(written.in_buffer_start_address,
+                     written.in_buffer_end_address[index]) > offset) {
+      record_latency(m_receive_latency, now - written.time[index]);
+      break;
+    }
+  }
+
+  push_timed_region(m_received_regions[reader],
+                    wrap_address(in_buffer_address + num_bytes), now);
+}
+
+void DmaNoCopy::track_done(size_t reader) {
+  if (m_enable_concurrent_mode) {
+    return;
+  }
+
+  const uint64_t now = get_latency_time();
+  uint64_t time = 0;
+
+  while (pop_timed_region(m_received_regions[reader],
+                          m_readers[reader].in_buffer_read_done_address,
+                          &time)) {
+    record_latency(m_hold_time, now - time);
+  }
+
+  while (pop_timed_region(m_written_regions, m_in_buffer_read_done_address,
+                          &time)) {
+  }
+}
+
+#endif // DMA_LATENCY_HISTOGRAM.
+
+Telemetry DmaNoCopy::get_telemetry() {
+  Telemetry result;
+
+  result.full_stall_cycles = registers.get_telemetry_full_stall_cycles();
+  result.axi_stall_cycles = registers.get_telemetry_axi_stall_cycles();
+  result.packets_written = registers.get_telemetry_packets_written();
+  result.peak_fill_bytes = registers.get_telemetry_peak_fill();
+
+  return result;
+}
+
+void DmaNoCopy::clear_telemetry() {
+  registers.set_telemetry_control_clear(true);
+}
+
+size_t DmaNoCopy::receive_packet_metadata(PacketMetadata *result,
+                                          size_t max_num_packets) {
+  // Read the level once, instead of before every packet, to save register
+  // reads.
+  // The level can only increase in the meantime.
+  const size_t level = registers.get_packet_metadata_status_level();
+  const size_t num_packets = std::min(level, max_num_packets);
+
+  for (size_t packet = 0; packet < num_packets; ++packet) {
+    result[packet].sequence_number =
+        registers.get_packet_metadata_sequence_number();
+    result[packet].timestamp_cycles =
+        (static_cast<uint64_t>(registers.get_packet_metadata_timestamp_high())
+         << 32) |
+        registers.get_packet_metadata_timestamp();
+    result[packet].num_padding_beats =
+        registers.get_packet_metadata_num_padding_beats();
+
+    registers.set_packet_metadata_control_pop(true);
   }
+
+  return num_packets;
+}
+
+void DmaNoCopy::set_concurrent_mode(bool enable) {
+  m_enable_concurrent_mode = enable;
+}
+
+uint32_t DmaNoCopy::get_oldest_done_address() const {
+  // All 'done' addresses are between the released address and the written
+  // address.
+  // The oldest one is the one closest to the released address.
+  size_t min_num_bytes_done = m_buffer_size_bytes;
+  for (size_t reader = 0; reader < m_num_readers; ++reader) {
+    const size_t num_bytes_done =
+        get_distance(m_in_buffer_read_released_address,
+                     m_readers[reader].in_buffer_read_done_address);
+    min_num_bytes_done = std::min(min_num_bytes_done, num_bytes_done);
+  }
+
+  return wrap_address(m_in_buffer_read_released_address + min_num_bytes_done);
+}
+
+bool DmaNoCopy::is_all_received_data_done() const {
+  for (size_t reader = 0; reader < m_num_readers; ++reader) {
+    if (m_readers[reader].in_buffer_read_done_address !=
+        m_readers[reader].in_buffer_read_outstanding_address.load(
+            std::memory_order_acquire)) {
+      return false;
+    }
+  }
+
+  return true;
 }
 
 void DmaNoCopy::clear_all_data() {
-  size_t written_address = registers.get_buffer_written_address();
-  registers.set_buffer_read_address(written_address);
-  m_in_buffer_read_outstanding_address = written_address - m_start_address;
-  m_in_buffer_read_done_address = m_in_buffer_read_outstanding_address;
+  update_written_address();
+  registers.set_buffer_read_address(static_cast<uint32_t>(m_start_address) +
+                                    m_in_buffer_written_address);
+
+  for (size_t reader = 0; reader < m_num_readers; ++reader) {
+    m_readers[reader].in_buffer_read_outstanding_address.store(
+        m_in_buffer_written_address, std::memory_order_relaxed);
+    m_readers[reader].in_buffer_read_done_address = m_in_buffer_written_address;
+    _DMA_TRACK_LATENCY(reset_timed_regions(m_received_regions[reader],
+                                           m_in_buffer_written_address));
+  }
+  m_in_buffer_read_done_address = m_in_buffer_written_address;
+  _DMA_TRACK_LATENCY(
+      reset_timed_regions(m_written_regions, m_in_buffer_written_address));
+  m_in_buffer_read_released_address = m_in_buffer_written_address;
+
+  m_num_tokens_outstanding = 0;
+  m_outstanding_tokens_mask.store(0, std::memory_order_relaxed);
+  m_released_tokens_mask.store(0, std::memory_order_relaxed);
 }
 
 size_t DmaNoCopy::get_num_bytes_available() {
-  // Code is fully duplicated in 'receive_data'.
-  size_t written_address = registers.get_buffer_written_address();
-  const size_t read_address =
-      m_start_address + m_in_buffer_read_outstanding_address;
+  return get_num_bytes_available(0);
+}
+
+size_t DmaNoCopy::get_num_bytes_available(size_t reader) {
+  _DMA_ASSERT_TRUE(reader < m_num_readers, invalid_reader, 0, reader,
+                   "Invalid reader: " << reader);
 
-  const size_t num_bytes_available =
-      (written_address - read_address) % m_buffer_size_bytes;
+  update_written_address();
 
-  return num_bytes_available;
+  return get_num_bytes_available_cached(reader);
+}
+
+size_t DmaNoCopy::add_reader() {
+  _DMA_ASSERT_TRUE(m_num_readers < max_num_readers, too_many_readers, 0,
+                   m_num_readers,
+                   "Can not add more than " << max_num_readers << " readers");
+
+  const size_t reader = m_num_readers;
+  m_readers[reader].in_buffer_read_outstanding_address.store(
+      m_in_buffer_read_released_address, std::memory_order_relaxed);
+  m_readers[reader].in_buffer_read_done_address =
+      m_in_buffer_read_released_address;
+  _DMA_TRACK_LATENCY(reset_timed_regions(m_received_regions[reader],
+                                         m_in_buffer_read_released_address));
+  ++m_num_readers;
+
+  return reader;
+}
+
+void DmaNoCopy::update_written_address() {
+  if (m_writeback_location == nullptr) {
+    m_in_buffer_written_address =
+        registers.get_buffer_written_address() -
+        static_cast<uint32_t>(m_start_address);
+    _DMA_TRACK_LATENCY(track_written());
+    return;
+  }
+
+  if (m_cache_invalidate_function != nullptr) {
+    m_cache_invalidate_function(
+        const_cast<const uint64_t *>(m_writeback_location),
+        sizeof(*m_writeback_location));
+  }
+
+  // Lower 32 bits are the address, upper are the sequence number.
+  // Acquire, so that the packet data is read after the address that says it
+  // has been written.
+  // The location is normal memory, so on weakly ordered CPUs the later loads
+  // of data could otherwise be satisfied before this one, and give stale data.
+  const uint64_t value = __atomic_load_n(
+      const_cast<const uint64_t *>(m_writeback_location), __ATOMIC_ACQUIRE);
+  m_writeback_sequence_number = static_cast<uint32_t>(value >> 32);
+  m_in_buffer_written_address =
+      static_cast<uint32_t>(value) - static_cast<uint32_t>(m_start_address);
+  _DMA_TRACK_LATENCY(track_written());
+}
+
+size_t DmaNoCopy::get_num_bytes_available_cached(size_t reader) const {
+  return get_distance(
+      m_readers[reader].in_buffer_read_outstanding_address.load(
+          std::memory_order_relaxed),
+      m_in_buffer_written_address);
 }
 
 bool DmaNoCopy::check_status() {
+  m_num_receives_since_status_check = 0;
+
   const uint32_t register_value = registers.get_interrupt_status();
   if (register_value) {
     // Read and then clear status ASAP.
     registers.set_interrupt_status(register_value);
 
+    if (register_value &
+        ~fpga_regs::dma_axi_write_simple::interrupt_status::write_done::
+            mask_shifted) {
+      _DMA_COUNT(num_error_interrupts, 1);
+    }
+
     _DMA_ASSERT_TRUE(
         !registers.get_interrupt_status_write_error_from_value(
             register_value) &&
@@ -162,6 +1149,7 @@ bool DmaNoCopy::check_status() {
             !registers
                  .get_interrupt_status_read_address_unaligned_error_from_value(
                      register_value),
+        error_interrupt, register_value, 0,
         "Got error interrupt from the FPGA AXI DMA write module: "
             << register_value);
   }
@@ -169,6 +1157,27 @@ bool DmaNoCopy::check_status() {
   return registers.get_interrupt_status_write_done_from_value(register_value);
 }
 
+#if defined(__aarch64__)
+void invalidate_data_cache(const void *data, size_t num_bytes) {
+  // The 'DminLine' field holds log2 of the smallest data cache line size,
+  // in words.
+  uint64_t cache_type;
+  asm volatile("mrs %0, ctr_el0" : "=r"(cache_type));
+  const uintptr_t line_size_bytes = uintptr_t(4) << ((cache_type >> 16) & 0xF);
+
+  const uintptr_t start = reinterpret_cast<uintptr_t>(data);
+  const uintptr_t end = start + num_bytes;
+
+  for (uintptr_t line = start & ~(line_size_bytes - 1); line < end;
+       line += line_size_bytes) {
+    asm volatile("dc civac, %0" : : "r"(line) : "memory");
+  }
+
+  // Make sure the maintenance is complete before any data is read.
+  asm volatile("dsb sy" : : : "memory");
+}
+#endif
+
 } // namespace dma_axi_write_simple
 
 } // namespace fpga
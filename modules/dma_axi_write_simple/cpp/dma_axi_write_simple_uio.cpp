@@ -0,0 +1,63 @@
+// -------------------------------------------------------------------------------------------------
+// Copyright (c) Lukas Vik. All rights reserved.
+//
+// This file is part of the hdl-modules project, a collection of reusable, high-quality,
+// peer-reviewed VHDL building blocks.
+// https://hdl-modules.com
+// https://github.com/hdl-modules/hdl-modules
+// -------------------------------------------------------------------------------------------------
+
+#include <poll.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "include/dma_axi_write_simple_uio.h"
+
+namespace fpga {
+
+namespace dma_axi_write_simple {
+
+bool wait_for_uio_interrupt(void *context, uint32_t timeout_us) {
+  const int file_descriptor = *static_cast<int *>(context);
+
+  if (!enable_uio_interrupt(file_descriptor)) {
+    return false;
+  }
+
+  struct pollfd poll_file_descriptor = {};
+  poll_file_descriptor.fd = file_descriptor;
+  poll_file_descriptor.events = POLLIN;
+
+  // Use 'ppoll' rather than 'poll' to get microsecond timeout resolution.
+  struct timespec timeout = {};
+  timeout.tv_sec = timeout_us / 1000000;
+  timeout.tv_nsec = (timeout_us % 1000000) * 1000;
+
+  if (ppoll(&poll_file_descriptor, 1, &timeout, nullptr) <= 0) {
+    return false;
+  }
+
+  return acknowledge_uio_interrupt(file_descriptor);
+}
+
+bool enable_uio_interrupt(int file_descriptor) {
+  // Writing a non-zero value to the UIO device will re-enable the interrupt.
+  // The 'interrupt' signal of the FPGA module is level sensitive, so if the
+  // status was set again since we last cleared it, this will trigger straight
+  // away.
+  const uint32_t enable_interrupt = 1;
+  return write(file_descriptor, &enable_interrupt, sizeof(enable_interrupt)) ==
+         sizeof(enable_interrupt);
+}
+
+bool acknowledge_uio_interrupt(int file_descriptor) {
+  // Reading is what acknowledges the event in the UIO framework.
+  // The value read is the total interrupt count, which we have no use for.
+  uint32_t interrupt_count = 0;
+  return read(file_descriptor, &interrupt_count, sizeof(interrupt_count)) ==
+         sizeof(interrupt_count);
+}
+
+} // namespace dma_axi_write_simple
+
+} // namespace fpga
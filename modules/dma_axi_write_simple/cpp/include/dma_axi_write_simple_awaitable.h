@@ -0,0 +1,179 @@
+// -------------------------------------------------------------------------------------------------
+// Copyright (c) Lukas Vik. All rights reserved.
+//
+// This file is part of the hdl-modules project, a collection of reusable, high-quality,
+// peer-reviewed VHDL building blocks.
+// https://hdl-modules.com
+// https://github.com/hdl-modules/hdl-modules
+// -------------------------------------------------------------------------------------------------
+
+#pragma once
+
+// Requires C++20 coroutines.
+#if __has_include(<coroutine>) && defined(__cpp_impl_coroutine)
+
+#include <coroutine>
+
+#include "dma_axi_write_simple_no_copy.h"
+#include "dma_axi_write_simple_uio.h"
+
+namespace fpga {
+
+namespace dma_axi_write_simple {
+
+/**
+ * Awaitable that resumes a coroutine once data is available in a DmaNoCopy
+ * object, with the interrupt handled by the Linux UIO framework.
+ * Makes it possible to handle many DMA channels, alongside e.g. network I/O,
+ * in one event loop thread, instead of one polling thread per channel.
+ *
+ *   const Response response = co_await DataAwaitable(
+ *       dma, uio_file_descriptor, wait_readable, &loop, min, max);
+ *
+ * The result works exactly like for DmaNoCopy::receive_data, and
+ * DmaNoCopy::done_with_data must be called for it.
+ * The result can have zero bytes if the UIO device could not be accessed.
+ *
+ * The class does not depend on any particular event loop.
+ * Instead, the user gives a function that registers the UIO file descriptor
+ * with the event loop.
+ * For example with 'asio', where the context is a
+ * 'asio::posix::stream_descriptor' of the UIO device:
+ *
+ *   descriptor->async_wait(asio::posix::stream_descriptor::wait_read,
+ *                          [=](auto) { callback(argument); });
+ *
+ * Or with 'io_uring', by submitting an 'IORING_OP_POLL_ADD' request for
+ * 'POLLIN', and calling the callback when the completion arrives.
+ *
+ * DmaNoCopy::enable_write_done_interrupt must have been called before the
+ * first wait.
+ * This class is not thread-safe, and the callback must be called from the
+ * thread that runs the coroutine.
+ * The callback may be called from within the registering function, e.g. if
+ * the event loop finds the file descriptor readable straight away.
+ * In that case the coroutine continues without being suspended, since it can
+ * not be resumed before it has finished suspending.
+ */
+class DataAwaitable {
+
+public:
+  /**
+   * Function that shall make the event loop call 'callback(argument)' once,
+   * the next time 'file_descriptor' is readable.
+   * Must return straight away, without waiting.
+   * The callback must be called exactly once for each call of this function,
+   * either later from the event loop or before this function returns.
+   */
+  using WaitReadableFunction = void (*)(void *context, int file_descriptor,
+                                        void (*callback)(void *),
+                                        void *argument);
+
+private:
+  DmaNoCopy &m_dma;
+  int m_file_descriptor;
+  WaitReadableFunction m_wait_readable_function;
+  void *m_wait_readable_context;
+  size_t m_min_num_bytes;
+  size_t m_max_num_bytes;
+
+  Response m_response = {};
+  std::coroutine_handle<> m_handle;
+
+  // Set while 'await_suspend' is running, during which the coroutine must not
+  // be resumed.
+  bool m_is_suspending = false;
+  // Set if the wait finished while 'await_suspend' was running.
+  bool m_finished_while_suspending = false;
+
+  /**
+   * Re-enable the interrupt and register with the event loop.
+   * Returns 'false' if the interrupt could not be enabled.
+   */
+  bool wait() {
+    // Re-enable after receive_data_before_wait has cleared the interrupt
+    // status, for the same reason as in 'wait_for_uio_interrupt'.
+    if (!enable_uio_interrupt(m_file_descriptor)) {
+      return false;
+    }
+
+    m_wait_readable_function(m_wait_readable_context, m_file_descriptor,
+                             &on_readable, this);
+
+    return true;
+  }
+
+  static void on_readable(void *argument) {
+    DataAwaitable *self = static_cast<DataAwaitable *>(argument);
+
+    if (acknowledge_uio_interrupt(self->m_file_descriptor)) {
+      self->m_response = self->m_dma.receive_data_before_wait(
+          self->m_min_num_bytes, self->m_max_num_bytes);
+
+      // Might be too little data even though the interrupt triggered,
+      // see DmaNoCopy::receive_data.
+      if (self->m_response.num_bytes == 0 && self->wait()) {
+        return;
+      }
+    }
+
+    if (self->m_is_suspending) {
+      // Called from within 'await_suspend'. Resuming here would be undefined
+      // behavior, so let 'await_suspend' continue the coroutine instead.
+      self->m_finished_while_suspending = true;
+      return;
+    }
+
+    // Note that the coroutine might destroy this object when resumed.
+    self->m_handle.resume();
+  }
+
+public:
+  /**
+   * Class constructor.
+   * @param dma The object to receive data from.
+   * @param file_descriptor File descriptor of the opened UIO device, e.g.
+   *                        from 'open("/dev/uio0", O_RDWR)'.
+   * @param wait_readable_function See DataAwaitable::WaitReadableFunction.
+   * @param wait_readable_context Pointer that will be passed on to
+   *                              'wait_readable_function'.
+   *                              Will not be dereferenced by this class.
+   * @param min_num_bytes See DmaNoCopy::receive_data.
+   * @param max_num_bytes See DmaNoCopy::receive_data.
+   */
+  DataAwaitable(DmaNoCopy &dma, int file_descriptor,
+                WaitReadableFunction wait_readable_function,
+                void *wait_readable_context, size_t min_num_bytes,
+                size_t max_num_bytes)
+      : m_dma(dma), m_file_descriptor(file_descriptor),
+        m_wait_readable_function(wait_readable_function),
+        m_wait_readable_context(wait_readable_context),
+        m_min_num_bytes(min_num_bytes), m_max_num_bytes(max_num_bytes) {}
+
+  bool await_ready() {
+    m_response =
+        m_dma.receive_data_before_wait(m_min_num_bytes, m_max_num_bytes);
+    return m_response.num_bytes > 0;
+  }
+
+  bool await_suspend(std::coroutine_handle<> handle) {
+    m_handle = handle;
+    m_finished_while_suspending = false;
+
+    m_is_suspending = true;
+    const bool is_waiting = wait();
+    m_is_suspending = false;
+
+    // Continue straight away, with zero bytes, if we can not wait.
+    // Or with the result, if the callback was called before 'wait' returned.
+    return is_waiting && !m_finished_while_suspending;
+  }
+
+  Response await_resume() const { return m_response; }
+};
+
+} // namespace dma_axi_write_simple
+
+} // namespace fpga
+
+#endif
@@ -0,0 +1,133 @@
+// -------------------------------------------------------------------------------------------------
+// Copyright (c) Lukas Vik. All rights reserved.
+//
+// This file is part of the hdl-modules project, a collection of reusable, high-quality,
+// peer-reviewed VHDL building blocks.
+// https://hdl-modules.com
+// https://github.com/hdl-modules/hdl-modules
+// -------------------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace fpga {
+
+namespace dma_axi_write_simple {
+
+/**
+ * Allocates a physically contiguous memory buffer for the DMA, and gives
+ * the physical address as well as the virtual address.
+ * These are the arguments needed by the DmaNoCopy constructor that takes a
+ * separate physical address:
+ *
+ *   DmaNoCopy dma(register_base_address, buffer.get_physical_address(),
+ *                 buffer.get_data(), buffer.get_buffer_size_bytes(), ...);
+ *
+ * Only available in Linux.
+ * Check DmaBuffer::is_valid after construction to see if allocation succeeded.
+ * On bare metal, this class is not needed.
+ * A statically allocated array with 'alignas' can be used directly instead.
+ */
+class DmaBuffer {
+
+private:
+  uint8_t *m_data = nullptr;
+  uint64_t m_physical_address = 0;
+  size_t m_buffer_size_bytes = 0;
+  // The size of the mapping, which can be larger than the buffer size.
+  size_t m_mapping_size_bytes = 0;
+  int m_file_descriptor = -1;
+
+public:
+  /**
+   * Allocate the buffer from the huge page pool of the kernel.
+   * Huge pages reduce the TLB pressure when processing the data, compared to
+   * normal 4 KiB pages.
+   * Each huge page is physically contiguous and aligned with its size, which
+   * satisfies the alignment requirement of any power-of-two packet length up
+   * to the huge page size.
+   *
+   * Requires that huge pages have been reserved, e.g. with
+   * 'echo 8 > /proc/sys/vm/nr_hugepages'.
+   * Requires the 'CAP_SYS_ADMIN' capability, in order to read the physical
+   * address from '/proc/self/pagemap'.
+   * If the buffer spans more than one huge page, the allocation fails unless
+   * the pages happened to be physically contiguous.
+   * Use a buffer size of at most one huge page, or reserve a larger huge page
+   * size with e.g. 'hugepagesz=1G' on the kernel command line.
+   *
+   * The memory is cacheable.
+   * Unless the FPGA writes it through a cache coherent port, a cache
+   * invalidate function must be set with
+   * DmaNoCopy::set_cache_invalidate_function.
+   *
+   * WARNING: The physical address is looked up once, at construction.
+   * The pages are locked, which keeps them from being swapped out, but the
+   * kernel does not guarantee that locked huge pages stay at the same physical
+   * address.
+   * They can be migrated by e.g. memory compaction, NUMA balancing or memory
+   * hot-unplug, after which the FPGA would write to memory that no longer
+   * belongs to the buffer.
+   * Hence, this is only safe on a system where the pages are not migrated.
+   * E.g. a kernel built without 'CONFIG_MIGRATION', or one with the sysctl
+   * 'vm.compact_unevictable_allowed' set to zero, which keeps compaction from
+   * moving locked pages, and without NUMA balancing or memory hot-unplug.
+   * Use the 'u-dma-buf' constructor when this can not be guaranteed.
+   *
+   * @param buffer_size_bytes Size of the buffer.
+   *                          Must be a multiple of the packet length used by
+   *                          the FPGA.
+   *                          The allocation is rounded up to a whole number
+   *                          of huge pages.
+   */
+  explicit DmaBuffer(size_t buffer_size_bytes);
+
+  /**
+   * Use a buffer from the 'u-dma-buf' kernel module, which allocates
+   * physically contiguous memory from CMA at boot.
+   *
+   * @param device_name Name of the buffer device, e.g. 'udmabuf0'.
+   *                    The buffer is accessed through '/dev/<device_name>',
+   *                    and its physical address and size are read from
+   *                    '/sys/class/u-dma-buf/<device_name>'.
+   * @param cacheable If 'false', the device is opened with 'O_SYNC', which
+   *                  gives an uncached mapping.
+   *                  If 'true', the mapping is cacheable, and a cache
+   *                  invalidate function must be set with
+   *                  DmaNoCopy::set_cache_invalidate_function unless the FPGA
+   *                  writes through a cache coherent port.
+   */
+  DmaBuffer(const char *device_name, bool cacheable);
+
+  /**
+   * Unmaps and frees the memory.
+   * Any DmaNoCopy that uses this object must not be used after this point.
+   */
+  ~DmaBuffer();
+
+  DmaBuffer(const DmaBuffer &) = delete;
+  DmaBuffer &operator=(const DmaBuffer &) = delete;
+
+  /**
+   * Returns 'true' if the memory buffer was allocated successfully.
+   */
+  bool is_valid() const { return m_data != nullptr; }
+
+  /**
+   * Virtual address of the buffer.
+   */
+  uint8_t *get_data() const { return m_data; }
+
+  /**
+   * Physical address of the buffer, as seen by the FPGA.
+   */
+  uint64_t get_physical_address() const { return m_physical_address; }
+
+  size_t get_buffer_size_bytes() const { return m_buffer_size_bytes; }
+};
+
+} // namespace dma_axi_write_simple
+
+} // namespace fpga
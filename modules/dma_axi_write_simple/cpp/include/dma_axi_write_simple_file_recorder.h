@@ -0,0 +1,191 @@
+// -------------------------------------------------------------------------------------------------
+// Copyright (c) Lukas Vik. All rights reserved.
+//
+// This file is part of the hdl-modules project, a collection of reusable, high-quality,
+// peer-reviewed VHDL building blocks.
+// https://hdl-modules.com
+// https://github.com/hdl-modules/hdl-modules
+// -------------------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <sys/types.h>
+
+#include "dma_axi_write_simple_no_copy.h"
+
+namespace fpga {
+
+namespace dma_axi_write_simple {
+
+/**
+ * Records the stream data of a DmaNoCopy object to a file, by submitting the
+ * regions of the ring buffer directly as asynchronous 'io_uring' writes.
+ * Each region is released to the FPGA once its write has completed.
+ * With the file opened with 'O_DIRECT', the data is written from the DMA
+ * buffer straight to the storage device, without any copy through the page
+ * cache.
+ *
+ * Several writes are kept in flight, and they may complete in any order.
+ * Uses the tokens of DmaNoCopy (see DmaNoCopy::receive_data_token) to release
+ * the buffer space in order.
+ * Meaning that the DmaNoCopy object must not be used for anything else while
+ * recording.
+ *
+ * Only available in Linux, version 5.6 or later.
+ * Uses the kernel interface directly, so there is no dependency on 'liburing'.
+ *
+ * Note that 'O_DIRECT' requires that the kernel can pin the pages of the
+ * memory buffer.
+ * That is not the case for memory that is mapped from e.g. '/dev/mem', in
+ * which case the writes will fail with 'EFAULT'.
+ * The recorder works also without 'O_DIRECT', but then the data is copied to
+ * the page cache by the kernel.
+ */
+class FileRecorder {
+
+public:
+  // Limited by the number of tokens in DmaNoCopy.
+  static const size_t max_queue_depth = DmaNoCopy::max_num_tokens;
+
+private:
+  DmaNoCopy &m_dma;
+  int m_file_descriptor;
+  size_t m_write_size_bytes;
+  size_t m_queue_depth;
+
+  // The 'io_uring' instance.
+  int m_ring_file_descriptor = -1;
+  void *m_submission_ring = nullptr;
+  size_t m_submission_ring_size_bytes = 0;
+  void *m_completion_ring = nullptr;
+  size_t m_completion_ring_size_bytes = 0;
+  void *m_submission_entries = nullptr;
+  size_t m_submission_entries_size_bytes = 0;
+
+  uint32_t *m_submission_tail = nullptr;
+  uint32_t m_submission_mask = 0;
+  uint32_t *m_submission_array = nullptr;
+  uint32_t *m_completion_head = nullptr;
+  uint32_t *m_completion_tail = nullptr;
+  uint32_t m_completion_mask = 0;
+  void *m_completion_entries = nullptr;
+
+  size_t m_num_writes_in_flight = 0;
+  off_t m_file_offset = 0;
+  uint64_t m_num_bytes_written = 0;
+  int m_error = 0;
+
+  // Entries that have been placed in the submission ring, but not yet been
+  // consumed by the kernel.
+  uint32_t m_num_entries_to_submit = 0;
+
+  /**
+   * Unmap and close everything that has been set up, leaving the object
+   * invalid.
+   */
+  void close_ring();
+
+  /**
+   * Tell the kernel about new submission entries, and optionally wait for
+   * completions.
+   */
+  bool enter(uint32_t min_num_completions);
+
+  /**
+   * Handle all completed writes.
+   * If 'min_num_completions' is non-zero, wait until at least that many have
+   * completed.
+   * Returns 'false' if the wait failed.
+   */
+  bool reap_completions(uint32_t min_num_completions);
+
+public:
+  /**
+   * Class constructor.
+   * Check FileRecorder::is_valid afterwards to see if the setup succeeded.
+   * DmaNoCopy::setup_and_enable can be called before or after this.
+   *
+   * @param dma The object to record data from.
+   *            Must not be destroyed while this object is in use.
+   * @param file_descriptor File to write to, opened for writing.
+   *                        E.g. with 'O_WRONLY | O_CREAT | O_DIRECT'.
+   *                        Data is written from offset zero in the file.
+   * @param write_size_bytes The number of bytes in each write.
+   *                         Must be a multiple of 'packet_length_bytes', and
+   *                         the buffer size of 'dma' must be a multiple of
+   *                         this value.
+   *                         With 'O_DIRECT', this must also be a multiple of
+   *                         the block size of the file system, and the memory
+   *                         buffer must be aligned with it.
+   *                         A value of e.g. 256 KiB or more is recommended for
+   *                         NVMe devices.
+   * @param packet_length_bytes The packet length used by the FPGA, i.e.
+   *                            'packet_length_beats' times the number of bytes
+   *                            per 'stream' beat.
+   * @param queue_depth The maximum number of writes in flight.
+   *                    At most FileRecorder::max_queue_depth.
+   */
+  FileRecorder(DmaNoCopy &dma, int file_descriptor, size_t write_size_bytes,
+               size_t packet_length_bytes, size_t queue_depth);
+
+  /**
+   * Waits for all writes in flight, see FileRecorder::finish.
+   */
+  ~FileRecorder();
+
+  FileRecorder(const FileRecorder &) = delete;
+  FileRecorder &operator=(const FileRecorder &) = delete;
+
+  /**
+   * Returns 'true' if the arguments were valid and 'io_uring' could be set up.
+   * The object is invalid if 'write_size_bytes' is not a multiple of
+   * 'packet_length_bytes', or if the buffer size is not a multiple of
+   * 'write_size_bytes'.
+   */
+  bool is_valid() const { return m_ring_file_descriptor >= 0; }
+
+  /**
+   * Release the buffer space of all completed writes, and submit writes for
+   * all available data, as long as there is room in the queue.
+   * Does not block.
+   * Shall be called regularly, e.g. in a loop or when the interrupt of the
+   * FPGA module has triggered.
+   *
+   * @return 'false' if a write has failed, see FileRecorder::get_error.
+   *         No further writes are submitted after that.
+   */
+  bool poll();
+
+  /**
+   * Like FileRecorder::poll, but if the queue is full or there is no new data,
+   * blocks until at least one write in flight has completed.
+   * Returns straight away if there are no writes in flight.
+   */
+  bool poll_and_wait();
+
+  /**
+   * Wait until all writes in flight have completed, and release their buffer
+   * space.
+   * Does not submit any new writes.
+   */
+  bool finish();
+
+  /**
+   * The total number of bytes that have been written to the file.
+   */
+  uint64_t get_num_bytes_written() const { return m_num_bytes_written; }
+
+  /**
+   * The negative 'errno' value of the first write that failed, or '-EIO' if
+   * the write was short.
+   * Zero if no write has failed.
+   */
+  int get_error() const { return m_error; }
+};
+
+} // namespace dma_axi_write_simple
+
+} // namespace fpga
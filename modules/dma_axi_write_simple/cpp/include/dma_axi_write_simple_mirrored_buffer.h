@@ -0,0 +1,86 @@
+// -------------------------------------------------------------------------------------------------
+// Copyright (c) Lukas Vik. All rights reserved.
+//
+// This file is part of the hdl-modules project, a collection of reusable, high-quality,
+// peer-reviewed VHDL building blocks.
+// https://hdl-modules.com
+// https://github.com/hdl-modules/hdl-modules
+// -------------------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <sys/types.h>
+
+namespace fpga {
+
+namespace dma_axi_write_simple {
+
+/**
+ * Maps a DMA memory buffer twice, back-to-back, in virtual memory.
+ * Meaning that the byte at 'get_data()[buffer_size_bytes + N]' is the same
+ * physical byte as 'get_data()[N]'.
+ * Any region of up to 'buffer_size_bytes' in the ring buffer can then be
+ * accessed contiguously, even if it wraps around the end of the buffer.
+ *
+ * Is meant to be used with the corresponding DmaNoCopy constructor.
+ * Only available in Linux.
+ * The accessors are defined inline, so that the DmaNoCopy implementation does
+ * not depend on the Linux-specific mapping code.
+ */
+class MirroredBuffer {
+
+private:
+  uint8_t *m_data = nullptr;
+  size_t m_buffer_size_bytes;
+
+public:
+  /**
+   * Class constructor.
+   * Check MirroredBuffer::is_valid afterwards to see if the mapping succeeded.
+   *
+   * @param file_descriptor File descriptor that gives access to the DMA memory
+   *                        buffer.
+   *                        For example from 'open("/dev/udmabuf0", ...)'
+   *                        with offset zero, or from 'open("/dev/mem", ...)'
+   *                        with the physical address as offset.
+   * @param offset Offset into the file where the DMA memory buffer starts.
+   *               Must be a multiple of the page size.
+   * @param buffer_size_bytes Size of the DMA memory buffer.
+   *                          Must be a multiple of the page size as well as the
+   *                          packet length used by the FPGA.
+   */
+  MirroredBuffer(int file_descriptor, off_t offset, size_t buffer_size_bytes);
+
+  /**
+   * Unmaps the memory.
+   * Any DmaNoCopy that uses this object must not be used after this point.
+   */
+  ~MirroredBuffer();
+
+  MirroredBuffer(const MirroredBuffer &) = delete;
+  MirroredBuffer &operator=(const MirroredBuffer &) = delete;
+
+  /**
+   * Returns 'true' if the memory buffer was mapped successfully.
+   */
+  bool is_valid() const { return m_data != nullptr; }
+
+  /**
+   * Pointer to the start of the first mapping.
+   * The memory is valid for '2 * get_buffer_size_bytes()' bytes.
+   */
+  uint8_t *get_data() const { return m_data; }
+
+  /**
+   * The size of the DMA memory buffer.
+   * I.e. half the size of the mapped virtual memory region.
+   */
+  size_t get_buffer_size_bytes() const { return m_buffer_size_bytes; }
+};
+
+} // namespace dma_axi_write_simple
+
+} // namespace fpga
@@ -0,0 +1,160 @@
+// -------------------------------------------------------------------------------------------------
+// Copyright (c) Lukas Vik. All rights reserved.
+//
+// This file is part of the hdl-modules project, a collection of reusable, high-quality,
+// peer-reviewed VHDL building blocks.
+// https://hdl-modules.com
+// https://github.com/hdl-modules/hdl-modules
+// -------------------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Register interface class generated by hdl-registers.
+#include "dma_axi_write_simple.h"
+
+#include "dma_axi_write_simple_no_copy.h"
+
+namespace fpga {
+
+namespace dma_axi_write_simple {
+
+/**
+ * Class for using the 'dma_axi_write_simple_multi_channel_axi_lite' FPGA
+ * module, which has many DMA channels behind one register bus and one AXI
+ * port.
+ *
+ * Each channel is handled by its own DmaNoCopy object, created by the user with
+ * the register base address given by
+ * DmaMultiChannel::get_channel_register_base_address.
+ * This class reads the summary register bank of the module, which contains the
+ * interrupt state and the 'buffer_written_address' of all channels in one
+ * contiguous block.
+ * That way, the state of all channels is known after one pass of consecutive
+ * register reads, instead of polling the register bank of each channel.
+ *
+ * The values are handed to the DmaNoCopy objects with
+ * DmaNoCopy::set_written_address.
+ * Note that only the lower 32 bits of the written address are available in the
+ * summary bank, so the memory buffers must not cross a 4 GiB address boundary.
+ */
+class DmaMultiChannel {
+
+public:
+  // Same limit as the FPGA module.
+  static const size_t max_num_channels = 32;
+
+  // The address offset between the register banks of two channels.
+  // Register constant, shared with the FPGA module.
+  static const uintptr_t channel_register_stride_bytes =
+      fpga_regs::dma_axi_write_simple::channel_register_stride_bytes;
+
+private:
+  volatile uint32_t *m_summary_registers;
+  size_t m_num_channels;
+
+  bool (*m_assertion_handler)(const std::string *);
+  bool (*m_error_handler)(const Error *) = nullptr;
+
+  DmaNoCopy *m_channels[max_num_channels] = {};
+
+  /**
+   * Returns 'false' if the channel index is not valid.
+   */
+  bool check_channel(size_t channel);
+
+public:
+  /**
+   * Class constructor.
+   * @param register_base_address Byte address where the registers of the
+   *                              'dma_axi_write_simple_multi_channel_axi_lite'
+   *                              module are memory mapped.
+   *                              When using an operating system, care must be
+   *                              taken to pass the virtual address, not the
+   *                              physical address.
+   * @param num_channels The 'num_channels' generic of the FPGA module.
+   * @param assertion_handler Function to call when an assertion fails in
+   *                          this class.
+   *                          Function takes a string pointer as an argument and
+   *                          must return a boolean 'true'.
+   */
+  DmaMultiChannel(uintptr_t register_base_address, size_t num_channels,
+                  bool (*assertion_handler)(const std::string *));
+
+  /**
+   * Report errors to this function, with the same error records and codes
+   * as DmaNoCopy::set_error_handler, instead of formatting a message for the
+   * assertion handler.
+   * Note that errors detected in the constructor will have been reported
+   * before this method can be called.
+   *
+   * @param error_handler Function that takes an error record pointer as an
+   *                      argument and must return a boolean 'true'.
+   *                      The pointer is only valid during the call.
+   */
+  void set_error_handler(bool (*error_handler)(const Error *));
+
+  /**
+   * The register base address of one channel, that shall be given to the
+   * DmaNoCopy constructor for that channel.
+   */
+  static uintptr_t get_channel_register_base_address(
+      uintptr_t register_base_address, size_t channel) {
+    return register_base_address +
+           (1 + channel) * channel_register_stride_bytes;
+  }
+
+  /**
+   * Attach the DmaNoCopy object that handles 'channel', so that it is updated
+   * by DmaMultiChannel::update.
+   * Will enable written address caching in the object
+   * (see DmaNoCopy::set_written_address_caching), since otherwise it would
+   * read its own register on every receive call anyway.
+   *
+   * @param channel Index of the channel.
+   * @param dma Object to attach.
+   *            Set to 'nullptr' to detach.
+   *            Will not be deleted by this class in any destructor, etc.
+   */
+  void set_channel(size_t channel, DmaNoCopy *dma);
+
+  /**
+   * Read the interrupt state of all channels.
+   * Will perform one register read.
+   *
+   * @return Bit N is set if the 'interrupt' of channel N is asserted.
+   */
+  uint32_t get_channel_interrupts();
+
+  /**
+   * Read the summary register bank.
+   * Will perform one register read for each channel, plus one, at consecutive
+   * addresses.
+   *
+   * @param written_addresses Array of at least 'num_channels' elements, where
+   *                          the lower 32 bits of the 'buffer_written_address'
+   *                          of each channel will be placed.
+   * @return Bit N is set if the 'interrupt' of channel N is asserted.
+   */
+  uint32_t read_summary(uint32_t *written_addresses);
+
+  /**
+   * Read the summary register bank, and hand the written addresses to all
+   * channels that have been attached with DmaMultiChannel::set_channel.
+   * After this call, DmaNoCopy::receive_data on those channels will not
+   * access any registers as long as there is enough data according to this
+   * update.
+   *
+   * @return Bit N is set if the 'interrupt' of channel N is asserted.
+   *         The interrupt status of the channel is cleared by the DmaNoCopy
+   *         object when it does access its registers.
+   */
+  uint32_t update();
+};
+
+} // namespace dma_axi_write_simple
+
+} // namespace fpga
@@ -12,15 +12,180 @@
 // Register interface class generated by hdl-registers.
 #include "dma_axi_write_simple.h"
 
+#include "dma_axi_write_simple_packet_view.h"
+
+#include <atomic>
+#include <optional>
+
+#if __has_include(<sys/uio.h>)
+#include <sys/uio.h>
+#endif
+
 namespace fpga {
 
 namespace dma_axi_write_simple {
 
+class MirroredBuffer;
+
 struct Response {
   size_t num_bytes;
   volatile void *data;
 };
 
+#if __has_include(<sys/uio.h>)
+// Use the POSIX type, so that segments can be passed directly to e.g.
+// 'writev' or 'sendmsg'.
+using Segment = struct iovec;
+#else
+// Same layout as the POSIX 'iovec' type, for platforms that do not have it.
+struct Segment {
+  void *iov_base;
+  size_t iov_len;
+};
+#endif
+
+// Same as Response, but with a plain pointer.
+// Used when the memory buffer is cacheable, see
+// DmaNoCopy::set_cache_invalidate_function.
+struct CacheableResponse {
+  size_t num_bytes;
+  const uint8_t *data;
+};
+
+// The different errors that can be detected by DmaNoCopy.
+enum class ErrorCode : uint32_t {
+  // The FPGA module has raised one of its error interrupts.
+  // See 'interrupt_status' of the Error for which one.
+  error_interrupt,
+  buffer_crosses_address_boundary,
+  invalid_mirrored_buffer,
+  already_enabled,
+  no_interrupt_wait_function,
+  too_many_readers,
+  // See 'value' of the Error for the reader index.
+  invalid_reader,
+  // A token that is out of range, not outstanding, or released twice.
+  // See 'value' of the Error for the token.
+  invalid_token,
+  tokens_in_concurrent_mode,
+  copy_in_concurrent_mode,
+  // See 'value' of the Error for the packet length.
+  invalid_packet_length,
+  // See 'value' of the Error for the reader index.
+  data_outstanding_before_copy,
+  // Reported by DmaMultiChannel.
+  // See 'value' of the Error for the number of channels.
+  invalid_num_channels,
+  // Reported by DmaMultiChannel.
+  // See 'value' of the Error for the channel index.
+  invalid_channel,
+};
+
+// Error record passed to the error handler, see DmaNoCopy::set_error_handler.
+// Fixed size, and does not own any memory.
+struct Error {
+  ErrorCode code;
+  // Source location of the check that failed.
+  const char *file;
+  uint32_t line;
+  // Raw value of the 'interrupt_status' register, for the 'error_interrupt'
+  // code.
+  // Otherwise zero.
+  uint32_t interrupt_status;
+  // The offending argument value, where applicable.
+  // Otherwise zero.
+  uint64_t value;
+};
+
+// Snapshot of the statistics counters, see DmaNoCopy::get_statistics.
+// All counters are zero unless the code is compiled with 'DMA_STATISTICS'
+// defined.
+struct Statistics {
+  // Number of calls to any of the receive methods.
+  uint64_t num_receive_calls;
+  // Number of those calls that returned zero bytes.
+  uint64_t num_empty_receives;
+  // Number of calls that returned fewer bytes than were available and
+  // requested, because the data wrapped around the end of the buffer.
+  uint64_t num_wrapped_short_receives;
+  // Total number of bytes returned by the receive methods.
+  uint64_t num_bytes_received;
+  // The highest number of bytes seen available for receiving at the same time.
+  // A value close to the buffer size means that the buffer has been full, and
+  // that the FPGA has likely stalled the data stream.
+  uint64_t max_num_bytes_available;
+  // Number of times the error interrupts have been seen.
+  uint64_t num_error_interrupts;
+  // Number of writes to the 'buffer_read_address' register.
+  uint64_t num_read_address_writes;
+};
+
+// Snapshot of one latency histogram, see DmaNoCopy::get_latency_histograms.
+// Bucket 'n' counts the latencies of at least 2^n and less than 2^(n + 1)
+// clock ticks.
+// Bucket zero also counts latencies of zero, and the last bucket also counts
+// all longer latencies.
+struct LatencyHistogram {
+  static const size_t num_buckets = 32;
+
+  uint64_t counts[num_buckets];
+  // The longest latency seen.
+  uint64_t max;
+};
+
+// Snapshot of the latency histograms, see DmaNoCopy::get_latency_histograms.
+// All counts are zero unless the code is compiled with
+// 'DMA_LATENCY_HISTOGRAM' defined.
+struct LatencyHistograms {
+  // From when the driver sees that data has been written by the FPGA, until
+  // the data is returned by a receive method.
+  // One sample for each receive that returns data, for its first byte.
+  LatencyHistogram receive_latency;
+  // From when data is returned by a receive method, until
+  // DmaNoCopy::done_with_data has been called for all of it.
+  // One sample for each receive that returns data.
+  LatencyHistogram hold_time;
+};
+
+// Values of the FPGA telemetry registers, see DmaNoCopy::get_telemetry.
+// See the register documentation for details.
+struct Telemetry {
+  uint32_t full_stall_cycles;
+  uint32_t axi_stall_cycles;
+  uint32_t packets_written;
+  uint32_t peak_fill_bytes;
+};
+
+// Metadata of one packet, see DmaNoCopy::receive_packet_metadata.
+struct PacketMetadata {
+  // Incremented for every packet by the FPGA.
+  // A gap means that the metadata of one or more packets has been dropped.
+  uint32_t sequence_number;
+  // Clock cycle counter value when the first beat of the packet arrived.
+  uint64_t timestamp_cycles;
+  // The number of zero-valued beats at the end of the packet, that were added
+  // when a partial packet was flushed (see DmaNoCopy::set_flush_timeout).
+  // The rest of the packet is stream data.
+  uint32_t num_padding_beats;
+};
+
+// Response from DmaNoCopy::receive_data_token.
+struct TokenResponse {
+  size_t num_bytes;
+  volatile void *data;
+  // Shall be passed to DmaNoCopy::release_token once done with the data.
+  size_t token;
+};
+
+struct IovResponse {
+  // Total number of bytes, in all segments.
+  size_t num_bytes;
+  // Zero if no data, two if the data wraps around the end of the buffer,
+  // otherwise one.
+  size_t num_segments;
+  Segment segments[2];
+};
+
 /**
  * Class with simple API for using the simple AXI DMA write FPGA module.
  * This class does not copy data from the memory buffer before passing it on to
@@ -32,16 +197,177 @@ struct Response {
  */
 class DmaNoCopy {
 
+public:
+  // The maximum number of readers, see DmaNoCopy::add_reader.
+  static const size_t max_num_readers = 4;
+  // The maximum number of tokens that can be outstanding at the same time,
+  // see DmaNoCopy::receive_data_token.
+  static const size_t max_num_tokens = 64;
+  // With written address writeback, the 'interrupt_status' register is read
+  // by only one in this many receive calls that access the memory location,
+  // see DmaNoCopy::set_written_address_writeback.
+  static const size_t num_receives_per_writeback_status_check = 64;
+
 private:
   volatile uint8_t *m_buffer;
   size_t m_buffer_size_bytes;
+  // If the buffer is mapped twice back-to-back in virtual memory, we can
+  // return data that wraps around the end of the buffer.
+  bool m_buffer_is_mirrored = false;
 
   bool (*m_assertion_handler)(const std::string *);
+  bool (*m_error_handler)(const Error *) = nullptr;
+
+  // Physical addresses, as seen by the FPGA.
+  uint64_t m_start_address;
+  uint64_t m_end_address;
 
-  uint32_t m_start_address;
-  uint32_t m_end_address;
-  uint32_t m_in_buffer_read_outstanding_address = 0;
+  // Created by the constructors that take a register base address.
+  // Empty if the user has given a register interface.
+  std::optional<fpga_regs::DmaAxiWriteSimple> m_own_registers;
+
+  // Read state of one reader of the data stream, see DmaNoCopy::add_reader.
+  // Expressed as offsets from the start of the buffer.
+  struct ReadCursor {
+    // Atomic since it is read by the 'done' thread in concurrent mode,
+    // see DmaNoCopy::set_concurrent_mode.
+    std::atomic<uint32_t> in_buffer_read_outstanding_address;
+    uint32_t in_buffer_read_done_address;
+  };
+  ReadCursor m_readers[max_num_readers] = {};
+  size_t m_num_readers = 1;
+
+  // The oldest 'done' address of all the readers.
+  // Data before this address is done for all readers, and can be released.
   uint32_t m_in_buffer_read_done_address = 0;
+  // The read address value that has been written to the FPGA register.
+  // Might lag behind the 'done' address, see
+  // DmaNoCopy::set_release_threshold.
+  uint32_t m_in_buffer_read_released_address = 0;
+  size_t m_release_threshold_bytes = 0;
+
+  // Local copy of the 'buffer_written_address' register.
+  // Expressed as an offset from the start of the buffer, just like the
+  // read addresses above.
+  uint32_t m_in_buffer_written_address = 0;
+  bool m_enable_written_address_caching = false;
+
+  // Memory location written by the FPGA, see
+  // DmaNoCopy::set_written_address_writeback.
+  volatile const uint64_t *m_writeback_location = nullptr;
+  uint32_t m_writeback_sequence_number = 0;
+  size_t m_num_receives_since_status_check = 0;
+
+  void (*m_cache_invalidate_function)(const void *, size_t) = nullptr;
+
+  bool (*m_interrupt_wait_function)(void *, uint32_t) = nullptr;
+  void *m_interrupt_wait_context = nullptr;
+
+  bool m_enable_concurrent_mode = false;
+
+  // Number of bytes of each outstanding token, in order of receiving.
+  // Used as a ring buffer, indexed by the token value.
+  uint32_t m_token_num_bytes[max_num_tokens] = {};
+  size_t m_oldest_token = 0;
+  size_t m_num_tokens_outstanding = 0;
+  // One bit per outstanding token, i.e. the same tokens as
+  // 'm_oldest_token' and 'm_num_tokens_outstanding'.
+  // Only written by the receiving thread, but read by DmaNoCopy::release_token
+  // to check the token.
+  std::atomic<uint64_t> m_outstanding_tokens_mask{0};
+  // One bit per token, set by DmaNoCopy::release_token.
+  // Can be written by any thread.
+  std::atomic<uint64_t> m_released_tokens_mask{0};
+
+#ifdef DMA_STATISTICS
+  // Each counter is written by only one thread, so it is updated with a
+  // relaxed load and store rather than an atomic read-modify-write.
+  // The atomic type is only so that DmaNoCopy::get_statistics can be called
+  // from any thread.
+  struct StatisticsCounters {
+    std::atomic<uint64_t> num_receive_calls{0};
+    std::atomic<uint64_t> num_empty_receives{0};
+    std::atomic<uint64_t> num_wrapped_short_receives{0};
+    std::atomic<uint64_t> num_bytes_received{0};
+    std::atomic<uint64_t> max_num_bytes_available{0};
+    std::atomic<uint64_t> num_error_interrupts{0};
+    std::atomic<uint64_t> num_read_address_writes{0};
+  };
+  StatisticsCounters m_statistics;
+#endif
+
+#ifdef DMA_LATENCY_HISTOGRAM
+  static const size_t max_num_timed_regions = 16;
+
+  // Consecutive regions of the buffer, each with a point in time.
+  // Expressed as the end address of each region, where the first region
+  // starts at the start address.
+  // Used as a ring buffer.
+  // When full, the newest region is extended instead of adding a new one.
+  // Meaning that the data in the extension is given a time that is too early.
+  struct TimedRegions {
+    uint32_t in_buffer_start_address;
+    uint32_t in_buffer_end_address[max_num_timed_regions];
+    uint64_t time[max_num_timed_regions];
+    size_t oldest;
+    size_t num_regions;
+  };
+  // When the data was seen as written.
+  // Regions are removed when the data is done for all readers.
+  TimedRegions m_written_regions = {};
+  // When the data was received, for each reader.
+  // Regions are removed when the data is done for the reader.
+  TimedRegions m_received_regions[max_num_readers] = {};
+
+  // Written by only one thread, just like the statistics counters.
+  struct LatencyHistogramCounters {
+    std::atomic<uint64_t> counts[LatencyHistogram::num_buckets] = {};
+    std::atomic<uint64_t> max{0};
+  };
+  LatencyHistogramCounters m_receive_latency;
+  LatencyHistogramCounters m_hold_time;
+
+  uint64_t (*m_latency_clock_function)() = nullptr;
+
+  /**
+   * The current time, from the latency clock function if set, otherwise from
+   * 'std::chrono::steady_clock'.
+   */
+  uint64_t get_latency_time() const;
+
+  void record_latency(LatencyHistogramCounters &histogram, uint64_t latency);
+
+  static void reset_timed_regions(TimedRegions &regions,
+                                  uint32_t in_buffer_address);
+
+  static void push_timed_region(TimedRegions &regions,
+                                uint32_t in_buffer_end_address, uint64_t time);
+
+  /**
+   * Remove the oldest region if it ends at or before the address.
+   * Returns 'true' and gives the time of the region if it was removed.
+   */
+  bool pop_timed_region(TimedRegions &regions, uint32_t in_buffer_address,
+                        uint64_t *time) const;
+
+  /**
+   * Add a region if the written address has moved since the last call.
+   */
+  void track_written();
+
+  /**
+   * Record the receive latency of data that has just been received, and
+   * remember when it was received.
+   */
+  void track_received(size_t reader, uint32_t in_buffer_address,
+                      size_t num_bytes);
+
+  /**
+   * Record the hold time of all regions that are now done for the reader, and
+   * forget written regions that are done for all readers.
+   */
+  void track_done(size_t reader);
+#endif
 
   /**
    * Returns 'true' if the 'write_done' interrupt has triggered.
@@ -49,10 +375,90 @@ private:
    */
   bool check_status();
 
+  /**
+   * Read the 'buffer_written_address' register, or the writeback memory
+   * location, and update our local copy.
+   */
+  void update_written_address();
+
+  /**
+   * Return the number of bytes between the current outstanding read address
+   * of the reader and our local copy of the written address.
+   * Does not perform any register access.
+   */
+  size_t get_num_bytes_available_cached(size_t reader) const;
+
+  /**
+   * Wrap an in-buffer address that has been advanced by at most one buffer
+   * size.
+   * Avoids the integer division of a modulo, which is slow on many embedded
+   * CPUs.
+   * Is also correct for buffer sizes that are not a power of two.
+   */
+  size_t wrap_address(size_t in_buffer_address) const {
+    return in_buffer_address >= m_buffer_size_bytes
+               ? in_buffer_address - m_buffer_size_bytes
+               : in_buffer_address;
+  }
+
+  /**
+   * Return the number of bytes from one in-buffer address forward to another,
+   * taking wrap-around into account.
+   * Unlike a modulo of the unsigned difference, this is correct for buffer
+   * sizes that are not a power of two.
+   */
+  size_t get_distance(size_t from_in_buffer_address,
+                      size_t to_in_buffer_address) const {
+    return to_in_buffer_address >= from_in_buffer_address
+               ? to_in_buffer_address - from_in_buffer_address
+               : to_in_buffer_address + m_buffer_size_bytes -
+                     from_in_buffer_address;
+  }
+
+  /**
+   * Return the 'done' address of the reader that is furthest behind.
+   */
+  uint32_t get_oldest_done_address() const;
+
+  /**
+   * Return 'true' if all readers have called DmaNoCopy::done_with_data for all
+   * the data they have received.
+   */
+  bool is_all_received_data_done() const;
+
+  /**
+   * Mark data as outstanding for the reader and return the number of bytes.
+   * The data starts at the outstanding read address of the reader from before
+   * the call.
+   * Arguments work like for DmaNoCopy::receive_data.
+   * @param allow_wrap If 'false', the data will not wrap around the end of
+   *                   the buffer, meaning that 'min_num_bytes' is not always
+   *                   honored.
+   */
+  size_t receive(size_t reader, size_t min_num_bytes, size_t max_num_bytes,
+                 bool allow_wrap);
+
+  /**
+   * Invalidate the data cache for a region of the memory buffer,
+   * if a cache invalidate function has been set.
+   */
+  void invalidate_cache(size_t in_buffer_address, size_t num_bytes) const;
+
   // Empty struct initialization -> all fields zero'd out.
   // (most importantly, the 'num_bytes' value).
   const Response response_zero_bytes = {};
 
+  /**
+   * Common constructor.
+   * Will create a register interface from 'register_base_address' if
+   * 'register_interface' is 'nullptr'.
+   */
+  DmaNoCopy(uintptr_t register_base_address,
+            fpga_regs::IDmaAxiWriteSimple *register_interface,
+            uint64_t buffer_physical_address, void *buffer,
+            size_t buffer_size_bytes,
+            bool (*assertion_handler)(const std::string *));
+
 public:
   /**
    * Class constructor.
@@ -76,6 +482,8 @@ public:
    *               physical and virtual memory address.
    *               Meaning this constructor is only suitable for bare
    *               metal applications.
+   *               When using an operating system, use the constructor that
+   *               takes a separate physical address instead.
    * @param buffer_size_bytes The number of bytes in the memory buffer.
    *                          I.e. the number of bytes that have been allocated
    *                          by the user for the 'buffer' argument.
@@ -85,11 +493,120 @@ public:
    *                          this class.
    *                          Function takes a string pointer as an argument and
    *                          must return a boolean 'true'.
+   *                          Is not used for errors in this class if an error
+   *                          handler has been set, see
+   *                          DmaNoCopy::set_error_handler.
    */
   DmaNoCopy(uintptr_t register_base_address, void *buffer,
             size_t buffer_size_bytes,
             bool (*assertion_handler)(const std::string *));
 
+  /**
+   * Class constructor for use with an operating system, where the physical
+   * address of the memory buffer, as seen by the FPGA, is different from the
+   * virtual address used by the software.
+   * For example a CMA buffer allocated with 'u-dma-buf' in Linux.
+   *
+   * @param register_base_address See the other constructor.
+   * @param buffer_physical_address The physical address of the memory buffer.
+   *                                This is the value that will be written to
+   *                                the 'buffer_start_address' registers.
+   *                                Must be aligned with the packet length used
+   *                                by the FPGA.
+   *                                Can be wider than 32 bits, in which case the
+   *                                'address_width' generic of the FPGA module
+   *                                must be set accordingly.
+   *                                The buffer must however not cross a 4 GiB
+   *                                address boundary.
+   * @param buffer Virtual address of the same memory buffer.
+   *               This is the address that will be used to access the data.
+   *               Will not be deleted by this class in any destructor, etc.
+   * @param buffer_size_bytes See the other constructor.
+   * @param assertion_handler See the other constructor.
+   */
+  DmaNoCopy(uintptr_t register_base_address, uint64_t buffer_physical_address,
+            void *buffer, size_t buffer_size_bytes,
+            bool (*assertion_handler)(const std::string *));
+
+  /**
+   * Class constructor for use with a memory buffer that is mapped twice
+   * back-to-back in virtual memory.
+   * With this constructor, DmaNoCopy::receive_data will be able to return
+   * data that wraps around the end of the ring buffer as one contiguous
+   * region.
+   * Meaning that it will always honor the 'min_num_bytes' argument.
+   *
+   * @param register_base_address See the other constructor.
+   * @param buffer_physical_address See the other constructors.
+   * @param buffer The virtual memory mapping of the buffer.
+   *               Must be valid, and must not be destroyed while this object
+   *               is in use.
+   *               The buffer size must be a multiple of the packet length used
+   *               by the FPGA.
+   * @param assertion_handler See the other constructor.
+   */
+  DmaNoCopy(uintptr_t register_base_address, uint64_t buffer_physical_address,
+            const MirroredBuffer &buffer,
+            bool (*assertion_handler)(const std::string *));
+
+  /**
+   * Class constructor that uses a register interface given by the user,
+   * instead of creating one from a register base address.
+   * Can be used to plug in e.g. an instrumented interface that counts or times
+   * the register accesses, or a software model of the FPGA module.
+   *
+   * Any class that implements the interface generated by hdl-registers can be
+   * used.
+   * The easiest way is to inherit the generated 'fpga_regs::DmaAxiWriteSimple'
+   * class and override only the methods of interest.
+   *
+   * @param register_interface Must be valid, and must not be destroyed while
+   *                           this object is in use.
+   *                           Will not be deleted by this class in any
+   *                           destructor, etc.
+   * @param buffer_physical_address See the other constructors.
+   * @param buffer See the other constructors.
+   * @param buffer_size_bytes See the other constructors.
+   * @param assertion_handler See the other constructors.
+   */
+  DmaNoCopy(fpga_regs::IDmaAxiWriteSimple *register_interface,
+            uint64_t buffer_physical_address, void *buffer,
+            size_t buffer_size_bytes,
+            bool (*assertion_handler)(const std::string *));
+
+  // Can not be copied or moved, since the object holds atomic state and a
+  // reference to its register interface.
+  // Use e.g. 'std::unique_ptr' or 'std::optional' to hold an object that is
+  // created later.
+  DmaNoCopy(const DmaNoCopy &) = delete;
+  DmaNoCopy &operator=(const DmaNoCopy &) = delete;
+
+  /**
+   * Set a function to call when an error is detected in this class, instead
+   * of the assertion handler given to the constructor.
+   * The function is given a fixed-size error record, without any formatted
+   * message.
+   * Meaning that no memory is allocated when an error occurs, and that
+   * formatting, if any, is left to the handler.
+   *
+   * If the code is compiled with 'NO_DMA_ASSERT_MESSAGE' defined, the
+   * formatting of messages for the assertion handler is removed completely,
+   * which avoids pulling in 'std::ostringstream'.
+   * In that case, errors are reported only through this error handler.
+   * Note that errors detected in the constructors will have been reported
+   * before this method can be called.
+   *
+   * @param error_handler Function that takes an error record pointer as an
+   *                      argument and must return a boolean 'true'.
+   *                      The pointer is only valid during the call.
+   */
+  void set_error_handler(bool (*error_handler)(const Error *));
+
+  /**
+   * The number of bytes in the memory buffer, as given to the constructor.
+   */
+  size_t get_buffer_size_bytes() const { return m_buffer_size_bytes; }
+
   /**
    * Write the necessary registers to setup the DMA module for operation, and
    * then enable it.
@@ -98,6 +615,26 @@ public:
    */
   void setup_and_enable();
 
+  /**
+   * Set the timeout after which the FPGA will pad a partial packet with zeros
+   * and write it to memory.
+   * The FPGA module must be built with the 'enable_flush_timeout' generic set,
+   * otherwise the register is not present and the write will fail.
+   *
+   * Note that the data returned by this class will then contain the padding.
+   * The 'buffer_written_address' is always aligned with the packet length,
+   * so no special handling is needed in this class.
+   * To tell the padding apart from data, build the FPGA module with also the
+   * 'enable_packet_metadata' generic set, and use
+   * PacketMetadata::num_padding_beats from
+   * DmaNoCopy::receive_packet_metadata.
+   *
+   * @param num_clock_cycles Number of clock cycles that the input stream must
+   *                         be idle in the middle of a packet before the flush.
+   *                         Zero disables the flush, which is the default.
+   */
+  void set_flush_timeout(uint32_t num_clock_cycles);
+
   /**
    * Receive all data that has been written by FPGA (no lower or upper limit for
    * byte count).
@@ -127,6 +664,9 @@ public:
    *
    * This method will check the current interrupt status, which will trigger an
    * assertion call if any error interrupt has occurred.
+   * With written address caching or writeback, the status is checked less
+   * often, see DmaNoCopy::set_written_address_caching and
+   * DmaNoCopy::set_written_address_writeback.
    *
    * @param min_num_bytes The minimum number of bytes we want to receive.
    *                      If fewer data bytes are available to read in memory,
@@ -148,6 +688,9 @@ public:
    *                      This corner case must be taken into account by the
    *                      user by always inspecting the number of bytes in the
    *                      response.
+   *                      Unless the class was constructed with a
+   *                      MirroredBuffer, in which case the corner case does
+   *                      not exist.
    * @param max_num_bytes If more than this number of data bytes are available
    *                      to read in memory, the method will split it up and
    *                      return 'max_num_bytes' bytes from this call.
@@ -157,6 +700,306 @@ public:
    */
   Response receive_data(size_t min_num_bytes, size_t max_num_bytes);
 
+  /**
+   * Variant of DmaNoCopy::receive_data that returns data wrapping around the
+   * end of the ring buffer as two segments, instead of returning only the
+   * first part.
+   * Meaning that 'min_num_bytes' is always honored, without the need to call
+   * again for the second part.
+   *
+   * The segments are of the POSIX 'iovec' type, and can be passed directly to
+   * e.g. 'writev' or 'sendmsg' for zero-copy forwarding of the data.
+   * Note that the segment pointers are not 'volatile' qualified, unlike the
+   * pointer in Response.
+   *
+   * The data is outstanding, and DmaNoCopy::done_with_data must be called
+   * with 'num_bytes' of the response, exactly as with
+   * DmaNoCopy::receive_data.
+   */
+  IovResponse receive_data_iov(size_t min_num_bytes, size_t max_num_bytes);
+
+  /**
+   * Set a function that invalidates the data cache for a region of memory.
+   * When set, the memory buffer is treated as normal cacheable memory, and
+   * all the receive methods of this class will invalidate exactly the regions
+   * they return, before returning.
+   *
+   * This is needed for correctness when the memory buffer is cacheable but
+   * the FPGA writes it through a port that is not cache coherent
+   * (e.g. an HP port instead of the ACP port on Zynq).
+   * Accessing cacheable memory is typically several times faster than
+   * accessing uncached memory, and makes it possible to use e.g. 'memcpy' or
+   * SIMD instructions on the data.
+   * Use DmaNoCopy::receive_data_cacheable to get a pointer without the
+   * 'volatile' qualifier.
+   *
+   * @param invalidate_function Function that takes a pointer and a number of
+   *                            bytes, and invalidates the data cache lines
+   *                            that cover that memory region.
+   *                            Can be e.g. 'Xil_DCacheInvalidateRange' in
+   *                            bare metal, or 'invalidate_data_cache' from
+   *                            this file on AArch64.
+   */
+  void set_cache_invalidate_function(void (*invalidate_function)(const void *,
+                                                                 size_t));
+
+  /**
+   * Same as DmaNoCopy::receive_data, but returns a plain pointer to the data.
+   * Is meant to be used when a cache invalidate function has been set
+   * (see DmaNoCopy::set_cache_invalidate_function), or when the buffer is
+   * coherent.
+   * The result can be wrapped in e.g. 'std::span(data, num_bytes)'.
+   */
+  CacheableResponse receive_data_cacheable(size_t min_num_bytes,
+                                           size_t max_num_bytes);
+
+  /**
+   * Receive data and copy it to a memory buffer owned by the user.
+   * The data is marked as done right away, meaning that
+   * DmaNoCopy::done_with_data shall NOT be called for it, and that the ring
+   * buffer space can be released to the FPGA much sooner than when processing
+   * the data in place.
+   *
+   * Data that wraps around the end of the ring buffer is copied in two parts,
+   * so 'min_num_bytes' is always honored.
+   *
+   * The copy uses non-temporal stores on x86 (SSE2) and AArch64, so that a
+   * large copy does not evict the working set of the application from the
+   * data cache.
+   * On other platforms, 'memcpy' is used.
+   * Note that the copy is much faster if the memory buffer is cacheable, see
+   * DmaNoCopy::set_cache_invalidate_function.
+   *
+   * Can not be used in concurrent mode (see DmaNoCopy::set_concurrent_mode).
+   * Can not be used while the reader has outstanding data from another receive
+   * method, i.e. data that DmaNoCopy::done_with_data has not been called for.
+   *
+   * On AArch64, an uncached memory buffer is typically mapped as device
+   * memory, where unaligned accesses fault.
+   * The copy therefore only uses aligned loads from the memory buffer there.
+   * On other platforms than x86 and AArch64, the memory buffer must be mapped
+   * as normal memory (cacheable or write-combining), since 'memcpy' might use
+   * unaligned loads.
+   *
+   * @param destination Memory buffer of at least 'max_num_bytes' bytes.
+   *                    Is best aligned to 16 bytes.
+   * @param min_num_bytes See DmaNoCopy::receive_data.
+   * @param max_num_bytes See DmaNoCopy::receive_data.
+   * @return The number of bytes that were copied.
+   *         Zero if fewer than 'min_num_bytes' bytes were available.
+   */
+  size_t receive_into(void *destination, size_t min_num_bytes,
+                      size_t max_num_bytes);
+
+  /**
+   * Same as DmaNoCopy::receive_data_cacheable, but returns the data as a
+   * range of fixed-size packets.
+   * The minimum and maximum are given as a number of packets, so they are
+   * always aligned with the packet length.
+   *
+   * The data is outstanding, and DmaNoCopy::done_with_data must be called
+   * with PacketView::get_num_bytes of the view, exactly as with
+   * DmaNoCopy::receive_data.
+   * As with DmaNoCopy::receive_data, the view can contain fewer than
+   * 'min_num_packets' packets when the data wraps around the end of the ring
+   * buffer, unless the class was constructed with a MirroredBuffer.
+   *
+   * @param packet_length_bytes The packet length used by the FPGA, i.e.
+   *                            'packet_length_beats' times the number of bytes
+   *                            per 'stream' beat.
+   *                            The buffer size and start address must be
+   *                            multiples of this value.
+   *                            Every received number of bytes must also be a
+   *                            multiple, which is checked.
+   * @param min_num_packets The minimum number of packets we want to receive.
+   * @param max_num_packets The maximum number of packets we want to receive.
+   *                        Can be e.g. 'SIZE_MAX' for no limit.
+   */
+  PacketView receive_packets(size_t packet_length_bytes, size_t min_num_packets,
+                             size_t max_num_packets);
+
+  /**
+   * Enable or disable caching of the 'buffer_written_address' register value.
+   * Disabled by default.
+   *
+   * When enabled, DmaNoCopy::receive_data will use the value from the last
+   * register read as long as that value indicates that at least
+   * 'min_num_bytes' are available.
+   * Only once the locally known data is exhausted will the registers be
+   * accessed again.
+   * Since register reads are usually very slow, this can give a significant
+   * speedup when receiving many small chunks of data.
+   *
+   * The downside is that
+   * - A call might return fewer bytes than are actually available in the
+   *   buffer, since more data might have been written since the last register
+   *   read.
+   *   It will however never return fewer than 'min_num_bytes', the corner case
+   *   described in DmaNoCopy::receive_data notwithstanding.
+   * - Error interrupts are only detected when the registers are read, not on
+   *   every call.
+   */
+  void set_written_address_caching(bool enable);
+
+  /**
+   * Update the local copy of the 'buffer_written_address' register with a
+   * value that has been read by other means.
+   * For example from the summary register bank of the
+   * 'dma_axi_write_simple_multi_channel_axi_lite' FPGA module, see
+   * DmaMultiChannel.
+   *
+   * Is only meaningful if written address caching is enabled
+   * (see DmaNoCopy::set_written_address_caching), since otherwise the register
+   * is read on every DmaNoCopy::receive_data call anyway.
+   *
+   * @param written_address The lower 32 bits of the 'buffer_written_address'
+   *                        register value.
+   */
+  void set_written_address(uint32_t written_address);
+
+  /**
+   * Make the FPGA write the 'buffer_written_address' value to a memory
+   * location every time it is updated, and read that location instead of the
+   * register.
+   * Requires that the 'enable_written_address_writeback' generic of the FPGA
+   * module is set, otherwise the registers are not present and the writes
+   * will fail.
+   * Must be called before DmaNoCopy::setup_and_enable.
+   *
+   * Since reading memory is much faster than reading a register, this makes
+   * the receive calls a lot cheaper.
+   * The receive calls then access the registers only rarely.
+   * The interrupt status is checked on one in
+   * DmaNoCopy::num_receives_per_writeback_status_check receive calls that
+   * read the memory location, and in DmaNoCopy::receive_data_before_wait,
+   * e.g. via DmaNoCopy::wait_for_data, when there is not enough data according
+   * to the memory location.
+   * Meaning that error interrupts are detected with a delay of a bounded
+   * number of calls, also in a purely polling workflow.
+   *
+   * In this mode, the FPGA triggers the 'write_done' interrupt once the
+   * memory location has been written, instead of once the data has been
+   * written.
+   *
+   * If a cache invalidate function has been set
+   * (see DmaNoCopy::set_cache_invalidate_function), it will be called on the
+   * location before every read.
+   *
+   * @param location Virtual address of the eight-byte memory location.
+   *                 Must be allocated by user.
+   *                 Will not be deleted by this class in any destructor, etc.
+   * @param location_physical_address Physical address of the same location,
+   *                                  as seen by the FPGA.
+   *                                  Must be aligned by 8 bytes, or the AXI
+   *                                  data width in bytes, whichever is
+   *                                  greater.
+   */
+  void set_written_address_writeback(volatile void *location,
+                                     uint64_t location_physical_address);
+
+  /**
+   * The sequence number from the last read of the writeback memory location.
+   * I.e. the number of packets that the FPGA had written at that point,
+   * modulo 2^32.
+   * See DmaNoCopy::set_written_address_writeback.
+   *
+   * Note that on a 32-bit CPU, the location might be read with two separate
+   * accesses, in which case this value can be from a different writeback than
+   * the written address.
+   * The written address itself is always valid.
+   */
+  uint32_t get_writeback_sequence_number() const {
+    return m_writeback_sequence_number;
+  }
+
+  /**
+   * Set the function that shall be used by DmaNoCopy::wait_for_data to block
+   * until the 'interrupt' signal of the FPGA module has triggered.
+   * Will also enable the 'write_done' interrupt in the 'interrupt_mask'
+   * register.
+   *
+   * @param wait_function Function that blocks until the interrupt has
+   *                      triggered, or until 'timeout_us' microseconds have
+   *                      passed.
+   *                      Takes the 'context' pointer and the timeout as
+   *                      arguments.
+   *                      Must return 'true' if the interrupt triggered and
+   *                      'false' if it timed out.
+   *
+   *                      For Linux, the function 'wait_for_uio_interrupt' in
+   *                      'dma_axi_write_simple_uio.h' can be used.
+   *                      For bare metal, this is typically a function that
+   *                      waits for a flag set by the interrupt service routine.
+   * @param context Pointer that will be passed on to 'wait_function'.
+   *                Will not be dereferenced by this class.
+   */
+  void set_interrupt_wait_function(bool (*wait_function)(void *, uint32_t),
+                                   void *context);
+
+  /**
+   * Enable the 'write_done' interrupt in the 'interrupt_mask' register.
+   * Is done by DmaNoCopy::set_interrupt_wait_function, but must be called
+   * explicitly when waiting for the interrupt in some other way, e.g. with
+   * DataAwaitable.
+   */
+  void enable_write_done_interrupt();
+
+  /**
+   * Configure coalescing of the 'write_done' interrupt, which lowers the
+   * interrupt rate when using DmaNoCopy::wait_for_data with short packets.
+   * The FPGA module must be built with the 'enable_interrupt_coalescing'
+   * generic set, otherwise the registers are not present and the writes
+   * will fail.
+   *
+   * @param num_packets Trigger the interrupt once this many packets have
+   *                    been written.
+   *                    Zero or one means every packet, which is the default.
+   * @param timeout_cycles Trigger the interrupt at most this many FPGA clock
+   *                       cycles after a packet has been written, even if
+   *                       fewer than 'num_packets' have been written.
+   *                       Gives a bound on the latency.
+   *                       Zero means no timeout, which is the default.
+   */
+  void set_interrupt_coalescing(uint32_t num_packets, uint32_t timeout_cycles);
+
+  /**
+   * Blocking variant of DmaNoCopy::receive_data.
+   * Will return straight away if the requested data is already available.
+   * Otherwise it will sleep until the 'write_done' interrupt has triggered,
+   * and only then check the registers again.
+   * This avoids the register traffic and CPU load of a polling workflow.
+   *
+   * DmaNoCopy::set_interrupt_wait_function must have been called before this
+   * method is used.
+   *
+   * The arguments 'min_num_bytes' and 'max_num_bytes', as well as the result,
+   * work exactly like for DmaNoCopy::receive_data.
+   *
+   * @param timeout_us Give up and return zero bytes if no interrupt has
+   *                   triggered within this many microseconds.
+   *                   Note that the timeout applies to each individual wait for
+   *                   an interrupt.
+   *                   If 'min_num_bytes' spans multiple packets, the total
+   *                   time spent in this method might be longer.
+   */
+  Response wait_for_data(size_t min_num_bytes, size_t max_num_bytes,
+                         uint32_t timeout_us);
+
+  /**
+   * Same as DmaNoCopy::receive_data, but if there is not enough data it also
+   * makes sure that the 'write_done' interrupt will trigger once more data
+   * has been written.
+   * Meaning that the caller can then safely wait for the interrupt.
+   * Is used by DmaNoCopy::wait_for_data, and can be used to implement other
+   * interrupt-driven workflows.
+   *
+   * With written address writeback (see
+   * DmaNoCopy::set_written_address_writeback), this is where the
+   * 'interrupt_status' register is accessed, apart from the periodic check
+   * for error interrupts.
+   */
+  Response receive_data_before_wait(size_t min_num_bytes, size_t max_num_bytes);
+
   /**
    * Indicate that we are done with data previously read with
    * DmaNoCopy::receive_data.
@@ -167,14 +1010,50 @@ public:
    * of bytes that has previously been read with DmaNoCopy::receive_data.
    *
    * Do not perform any 'delete' on the data.
+   *
+   * Note that, depending on the release threshold
+   * (see DmaNoCopy::set_release_threshold), the FPGA might not be notified
+   * straight away.
    */
   void done_with_data(size_t num_bytes);
 
+  /**
+   * Set the number of bytes that must be marked as done with
+   * DmaNoCopy::done_with_data before the 'buffer_read_address' register is
+   * updated.
+   * Default is zero, meaning that the register is written on every
+   * DmaNoCopy::done_with_data call.
+   *
+   * A higher value means fewer register writes, at the cost of the FPGA having
+   * access to less of the buffer.
+   * At most 'num_bytes' minus one packet of buffer space will be held back in
+   * this way.
+   * To avoid a deadlock where the FPGA waits for buffer space and the software
+   * waits for data, any pending data is always released when
+   * DmaNoCopy::receive_data finds too little data available.
+   * In concurrent mode (see DmaNoCopy::set_concurrent_mode), it is instead
+   * released when DmaNoCopy::done_with_data is called for the last of the
+   * received data.
+   *
+   * @param num_bytes Release threshold.
+   *                  For example 'buffer_size_bytes / 4' to release in
+   *                  quarters of the buffer.
+   */
+  void set_release_threshold(size_t num_bytes);
+
+  /**
+   * Update the 'buffer_read_address' register with all data that has been
+   * marked as done with DmaNoCopy::done_with_data, regardless of the release
+   * threshold.
+   * Will not perform any register write if there is nothing to release.
+   */
+  void flush_release();
+
   /**
    * Clear all DMA data, which means
    * - Indicate to the FPGA that the whole memory buffer is free to be written.
    * - Reset the DmaNoCopy::receive_data/DmaNoCopy::done_with_data state,
-   *   so that no data is considered outstanding.
+   *   so that no data is considered outstanding, for all readers.
    *
    * An implication of this is that if you have data that has been received with
    * DmaNoCopy::receive_data, but you are not yet finished with it and have
@@ -199,19 +1078,253 @@ public:
    * Instead, call DmaNoCopy::receive_data, either
    * - with the exact number of bytes you want as the arguments, or
    * - with a range and then check how much data you got as a response.
+   *
+   * If written address caching is enabled
+   * (see DmaNoCopy::set_written_address_caching), the value read by this
+   * method will be cached and used by the next DmaNoCopy::receive_data call.
+   * In that case there is no duplicate register read.
    */
   size_t get_num_bytes_available();
 
+  /**
+   * Add a reader of the data stream.
+   * Each reader has its own independent receive/done state, and will be given
+   * all data that is written by the FPGA.
+   * A part of the memory buffer is free to be written by the FPGA again only
+   * once all readers have called DmaNoCopy::done_with_data for it.
+   * This makes it possible to e.g. have both a recording thread and an
+   * analysis thread consume the same data, without copying it.
+   *
+   * There is always one reader, with index zero, which is used by the
+   * methods that do not take a 'reader' argument.
+   * The methods that do take a 'reader' argument work exactly like their
+   * counterparts, but for the given reader.
+   *
+   * Should be called before DmaNoCopy::setup_and_enable.
+   * If called later, the new reader will start at the oldest data that
+   * has not yet been released to the FPGA.
+   *
+   * Note that this class is not thread-safe, so if the readers are used from
+   * different threads, the calls must be synchronized by the user.
+   * DmaNoCopy::set_concurrent_mode does not change this, it only permits one
+   * receiving thread and one 'done' thread in total.
+   *
+   * @return The index of the new reader, to be used as the 'reader' argument.
+   */
+  size_t add_reader();
+
+  Response receive_data(size_t reader, size_t min_num_bytes,
+                        size_t max_num_bytes);
+  IovResponse receive_data_iov(size_t reader, size_t min_num_bytes,
+                               size_t max_num_bytes);
+  CacheableResponse receive_data_cacheable(size_t reader, size_t min_num_bytes,
+                                           size_t max_num_bytes);
+  size_t receive_into(size_t reader, void *destination, size_t min_num_bytes,
+                      size_t max_num_bytes);
+  PacketView receive_packets(size_t reader, size_t packet_length_bytes,
+                             size_t min_num_packets, size_t max_num_packets);
+  Response wait_for_data(size_t reader, size_t min_num_bytes,
+                         size_t max_num_bytes, uint32_t timeout_us);
+  Response receive_data_before_wait(size_t reader, size_t min_num_bytes,
+                                    size_t max_num_bytes);
+  void done_with_data(size_t reader, size_t num_bytes);
+  size_t get_num_bytes_available(size_t reader);
+
+  /**
+   * Enable or disable concurrent mode.
+   * Disabled by default.
+   *
+   * In concurrent mode, the receiving methods
+   * (DmaNoCopy::receive_data, DmaNoCopy::receive_data_iov,
+   * DmaNoCopy::receive_data_cacheable, DmaNoCopy::wait_for_data and
+   * DmaNoCopy::get_num_bytes_available) may be called from one thread, while
+   * DmaNoCopy::done_with_data and DmaNoCopy::flush_release are called from
+   * another thread, without any locking.
+   * For example a polling thread that receives data and passes it on to a
+   * worker thread, which calls DmaNoCopy::done_with_data once it is finished.
+   *
+   * The state shared between the two threads is handed over with atomic
+   * operations.
+   * The receiving thread is the only one that accesses the 'interrupt_status'
+   * and 'buffer_written_address' registers, and the 'done' thread is the only
+   * one that writes the 'buffer_read_address' register.
+   * Hence, the receiving methods will never release buffer space to the FPGA
+   * in this mode.
+   * See DmaNoCopy::set_release_threshold for how this affects the
+   * release behavior.
+   *
+   * If there are multiple readers, the receiving calls for all readers must be
+   * made from the same thread, and likewise for the 'done' calls.
+   * All other methods of this class must only be called when neither of the
+   * two threads is using the object.
+   */
+  void set_concurrent_mode(bool enable);
+
+  /**
+   * Return a snapshot of the latency histograms.
+   * Shows how long data sits in the memory buffer before it is received, and
+   * how long the readers hold on to it, which sets how large the buffer must
+   * be.
+   * Can be called from any thread.
+   *
+   * Latencies are only recorded if the code is compiled with
+   * 'DMA_LATENCY_HISTOGRAM' defined.
+   * Otherwise, the instrumentation is removed entirely, and all values are
+   * zero.
+   * The histograms have a fixed size, and are updated without any locking or
+   * memory allocation.
+   * Nothing is recorded in concurrent mode, see DmaNoCopy::set_concurrent_mode.
+   *
+   * Note that the receive latency is counted from when the driver reads the
+   * updated 'buffer_written_address' value, not from when the FPGA wrote the
+   * data.
+   * For the arrival time in the FPGA, see DmaNoCopy::receive_packet_metadata.
+   */
+  LatencyHistograms get_latency_histograms() const;
+
+  /**
+   * Set the clock that is used for the latency histograms.
+   * By default, nanoseconds from 'std::chrono::steady_clock' are used.
+   * Can be used on bare metal, where there might be no such clock, or to use
+   * e.g. a CPU cycle counter.
+   * Has no effect unless the code is compiled with 'DMA_LATENCY_HISTOGRAM'
+   * defined.
+   *
+   * @param clock_function Function that returns the current time, in any
+   *                       unit.
+   *                       Must increase monotonically.
+   */
+  void set_latency_clock_function(uint64_t (*clock_function)());
+
+  /**
+   * Return a snapshot of the statistics counters.
+   * Can be used to e.g. size the memory buffer and the release threshold, or
+   * to spot backpressure towards the FPGA before it leads to data loss.
+   *
+   * Counting is only enabled if the code is compiled with 'DMA_STATISTICS'
+   * defined, otherwise all values are zero.
+   * Can be called from any thread, but the values are not guaranteed to be
+   * consistent with each other if other threads are using the object.
+   */
+  Statistics get_statistics() const;
+
+  /**
+   * Read the telemetry registers of the FPGA module.
+   * These count e.g. how many clock cycles the input stream has been stalled
+   * because the buffer was full, which can not be observed from software.
+   *
+   * The FPGA module must be built with the 'enable_telemetry' generic set,
+   * otherwise the registers are not present and the reads will fail.
+   * Note that the four values are read one at a time, so they are not
+   * sampled at exactly the same time.
+   */
+  Telemetry get_telemetry();
+
+  /**
+   * Clear the telemetry counters of the FPGA module.
+   * See DmaNoCopy::get_telemetry.
+   */
+  void clear_telemetry();
+
+  /**
+   * Read and remove the metadata of the oldest packets from the FIFO in the
+   * FPGA module.
+   * The metadata is in the same order as the packets in the memory buffer.
+   * E.g. after a DmaNoCopy::receive_data call, use a 'max_num_packets' of
+   * the number of bytes received divided by the packet length, to get the
+   * metadata of the packets that were received.
+   *
+   * The FPGA module must be built with the 'enable_packet_metadata' generic
+   * set, otherwise the registers are not present and the reads will fail.
+   * Note that the FIFO contains also packets that have been accepted by the
+   * FPGA, but not yet been written to memory.
+   * So calling this method for more packets than have been received will make
+   * the metadata go out of sync with the data.
+   *
+   * Each packet costs four register reads and one register write.
+   *
+   * @param result Array where the metadata is placed, oldest packet first.
+   * @param max_num_packets The maximum number of packets to read.
+   *                        Must be at most the size of 'result'.
+   * @return The number of packets placed in 'result'.
+   *         Can be fewer than 'max_num_packets' if the FIFO has fewer packets.
+   */
+  size_t receive_packet_metadata(PacketMetadata *result,
+                                 size_t max_num_packets);
+
+  /**
+   * Variant of DmaNoCopy::receive_data that also returns a token, for use
+   * when the data is processed by multiple worker threads that might finish
+   * out of order.
+   *
+   * Instead of calling DmaNoCopy::done_with_data, each token shall be passed
+   * to DmaNoCopy::release_token once the data is done.
+   * The tokens can be released in any order, and from any thread.
+   * Buffer space is released to the FPGA up until the oldest token that is
+   * still outstanding.
+   *
+   * Released tokens are collected by this method, or by
+   * DmaNoCopy::collect_released_tokens.
+   * Hence, these must be called from the same thread, and not concurrently
+   * with any other method except DmaNoCopy::release_token.
+   *
+   * Will return zero bytes if there are already DmaNoCopy::max_num_tokens
+   * tokens outstanding.
+   * Uses the default reader, and must not be mixed with
+   * DmaNoCopy::receive_data or DmaNoCopy::done_with_data for that reader.
+   * Can not be used in concurrent mode (see DmaNoCopy::set_concurrent_mode).
+   *
+   * Arguments work exactly like for DmaNoCopy::receive_data.
+   */
+  TokenResponse receive_data_token(size_t min_num_bytes, size_t max_num_bytes);
+
+  /**
+   * Indicate that we are done with the data of a token previously returned by
+   * DmaNoCopy::receive_data_token.
+   * Is lock-free and can be called from any thread.
+   * Does not perform any register access.
+   * The buffer space is released to the FPGA by the next call to
+   * DmaNoCopy::receive_data_token or DmaNoCopy::collect_released_tokens.
+   *
+   * Each token must be released exactly once.
+   * A token that is not outstanding, or is released twice, is reported as
+   * ErrorCode::invalid_token.
+   */
+  void release_token(size_t token);
+
+  /**
+   * Collect all tokens that have been released with DmaNoCopy::release_token,
+   * up until the oldest token that is still outstanding, and mark their data
+   * as done.
+   * Is called automatically by DmaNoCopy::receive_data_token, but can also be
+   * called explicitly by the receiving thread to release buffer space sooner.
+   *
+   * @return The number of bytes that were marked as done.
+   */
+  size_t collect_released_tokens();
+
   /**
    * Interface to access the registers of the FPGA module.
    *
    * Can be used to e.g. enable the interrupts that you want.
    * Other than that, you are encouraged to use the API in this class
    * rather than accessing the registers directly.
+   *
+   * Is the interface given to the constructor, if any.
    */
-  fpga_regs::DmaAxiWriteSimple registers;
+  fpga_regs::IDmaAxiWriteSimple &registers;
 };
 
+#if defined(__aarch64__)
+/**
+ * Clean and invalidate the data cache lines that cover the given memory region.
+ * Uses the 'DC CIVAC' instruction, which is accessible from user space in
+ * Linux.
+ * Can be used as the argument to DmaNoCopy::set_cache_invalidate_function.
+ */
+void invalidate_data_cache(const void *data, size_t num_bytes);
+#endif
+
 } // namespace dma_axi_write_simple
 
 } // namespace fpga
@@ -0,0 +1,180 @@
+// -------------------------------------------------------------------------------------------------
+// Copyright (c) Lukas Vik. All rights reserved.
+//
+// This file is part of the hdl-modules project, a collection of reusable, high-quality,
+// peer-reviewed VHDL building blocks.
+// https://hdl-modules.com
+// https://github.com/hdl-modules/hdl-modules
+// -------------------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+
+namespace fpga {
+
+namespace dma_axi_write_simple {
+
+/**
+ * View of received data as a range of fixed-size packets.
+ * Is returned by DmaNoCopy::receive_packets.
+ *
+ * Can be used directly in a range-based for loop, where each element is a
+ * pointer to the first byte of a packet:
+ *
+ *   for (const uint8_t *packet : view) { ... }
+ *
+ * The iterators are random access, so the view can also be given to the
+ * standard algorithms with a parallel execution policy, e.g.
+ * 'std::for_each(std::execution::par, view.begin(), view.end(), ...)'.
+ *
+ * The view does not own any data, and is valid only until
+ * DmaNoCopy::done_with_data is called for the data.
+ * The accessors are defined inline, so that iteration compiles down to a
+ * pointer increment.
+ */
+class PacketView {
+
+public:
+  class Iterator {
+
+  private:
+    const uint8_t *m_data = nullptr;
+    size_t m_packet_length_bytes = 0;
+
+  public:
+    // The reference type is a value, like for many proxy iterators.
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = const uint8_t *;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const value_type *;
+    using reference = value_type;
+
+    Iterator() = default;
+    Iterator(const uint8_t *data, size_t packet_length_bytes)
+        : m_data(data), m_packet_length_bytes(packet_length_bytes) {}
+
+    value_type operator*() const { return m_data; }
+    value_type operator[](difference_type num_packets) const {
+      return *(*this + num_packets);
+    }
+
+    Iterator &operator+=(difference_type num_packets) {
+      m_data +=
+          num_packets * static_cast<difference_type>(m_packet_length_bytes);
+      return *this;
+    }
+    Iterator &operator-=(difference_type num_packets) {
+      return *this += -num_packets;
+    }
+
+    Iterator &operator++() { return *this += 1; }
+    Iterator &operator--() { return *this -= 1; }
+    Iterator operator++(int) {
+      Iterator result = *this;
+      ++*this;
+      return result;
+    }
+    Iterator operator--(int) {
+      Iterator result = *this;
+      --*this;
+      return result;
+    }
+
+    friend Iterator operator+(Iterator iterator, difference_type num_packets) {
+      return iterator += num_packets;
+    }
+    friend Iterator operator+(difference_type num_packets, Iterator iterator) {
+      return iterator += num_packets;
+    }
+    friend Iterator operator-(Iterator iterator, difference_type num_packets) {
+      return iterator -= num_packets;
+    }
+    friend difference_type operator-(const Iterator &left,
+                                     const Iterator &right) {
+      return (left.m_data - right.m_data) /
+             static_cast<difference_type>(left.m_packet_length_bytes);
+    }
+
+    friend bool operator==(const Iterator &left, const Iterator &right) {
+      return left.m_data == right.m_data;
+    }
+    friend bool operator!=(const Iterator &left, const Iterator &right) {
+      return left.m_data != right.m_data;
+    }
+    friend bool operator<(const Iterator &left, const Iterator &right) {
+      return left.m_data < right.m_data;
+    }
+    friend bool operator>(const Iterator &left, const Iterator &right) {
+      return left.m_data > right.m_data;
+    }
+    friend bool operator<=(const Iterator &left, const Iterator &right) {
+      return left.m_data <= right.m_data;
+    }
+    friend bool operator>=(const Iterator &left, const Iterator &right) {
+      return left.m_data >= right.m_data;
+    }
+  };
+
+private:
+  const uint8_t *m_data = nullptr;
+  size_t m_num_bytes = 0;
+  size_t m_packet_length_bytes = 0;
+
+public:
+  PacketView() = default;
+
+  /**
+   * Class constructor.
+   * @param data Pointer to the first packet.
+   * @param num_bytes Total number of bytes in the view.
+   *                  Must be a multiple of 'packet_length_bytes', which is
+   *                  checked by DmaNoCopy::receive_packets.
+   *                  Otherwise the last, partial, packet would not be part
+   *                  of the range.
+   * @param packet_length_bytes The number of bytes in each packet.
+   */
+  PacketView(const uint8_t *data, size_t num_bytes, size_t packet_length_bytes)
+      : m_data(data), m_num_bytes(num_bytes),
+        m_packet_length_bytes(packet_length_bytes) {}
+
+  Iterator begin() const { return Iterator(m_data, m_packet_length_bytes); }
+  Iterator end() const {
+    return Iterator(m_data + m_num_bytes, m_packet_length_bytes);
+  }
+
+  /**
+   * Pointer to the first byte of packet number 'packet_index'.
+   */
+  const uint8_t *operator[](size_t packet_index) const {
+    return m_data + packet_index * m_packet_length_bytes;
+  }
+
+  bool empty() const { return m_num_bytes == 0; }
+
+  /**
+   * The number of packets in the view.
+   */
+  size_t size() const {
+    return m_num_bytes == 0 ? 0 : m_num_bytes / m_packet_length_bytes;
+  }
+
+  /**
+   * The total number of bytes in the view.
+   * This is the value that shall be given to DmaNoCopy::done_with_data.
+   */
+  size_t get_num_bytes() const { return m_num_bytes; }
+
+  size_t get_packet_length_bytes() const { return m_packet_length_bytes; }
+
+  /**
+   * Pointer to the first byte of the first packet.
+   */
+  const uint8_t *get_data() const { return m_data; }
+};
+
+} // namespace dma_axi_write_simple
+
+} // namespace fpga
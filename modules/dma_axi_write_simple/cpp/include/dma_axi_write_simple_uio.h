@@ -0,0 +1,59 @@
+// -------------------------------------------------------------------------------------------------
+// Copyright (c) Lukas Vik. All rights reserved.
+//
+// This file is part of the hdl-modules project, a collection of reusable, high-quality,
+// peer-reviewed VHDL building blocks.
+// https://hdl-modules.com
+// https://github.com/hdl-modules/hdl-modules
+// -------------------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <cstdint>
+
+namespace fpga {
+
+namespace dma_axi_write_simple {
+
+/**
+ * Wait for the 'interrupt' signal of the FPGA module using the Linux
+ * Userspace I/O (UIO) framework.
+ * Is meant to be used as the argument to
+ * DmaNoCopy::set_interrupt_wait_function.
+ *
+ * The interrupt must be handled by a UIO driver that supports re-enabling
+ * the interrupt from user space, e.g. 'uio_pdrv_genirq'.
+ * The interrupt is re-enabled before each wait, so that an interrupt that
+ * triggered after the last register check is not missed.
+ *
+ * @param context Pointer to an 'int' that holds the file descriptor of the
+ *                opened UIO device, e.g. from 'open("/dev/uio0", O_RDWR)'.
+ * @param timeout_us Maximum time to wait, in microseconds.
+ * @return 'true' if the interrupt triggered, 'false' at timeout or error.
+ */
+bool wait_for_uio_interrupt(void *context, uint32_t timeout_us);
+
+/**
+ * Re-enable the interrupt of a UIO device, without waiting.
+ * For use with an event loop, where the file descriptor is polled for
+ * readability by the loop, instead of by 'wait_for_uio_interrupt'.
+ * Must be called before each wait, for the same reason as in
+ * 'wait_for_uio_interrupt'.
+ *
+ * @param file_descriptor File descriptor of the opened UIO device.
+ * @return 'true' if successful.
+ */
+bool enable_uio_interrupt(int file_descriptor);
+
+/**
+ * Acknowledge the interrupt event of a UIO device, once the file descriptor
+ * has become readable.
+ *
+ * @param file_descriptor File descriptor of the opened UIO device.
+ * @return 'true' if successful.
+ */
+bool acknowledge_uio_interrupt(int file_descriptor);
+
+} // namespace dma_axi_write_simple
+
+} // namespace fpga
@@ -13,7 +13,13 @@ from typing import TYPE_CHECKING, Any
 
 from tsfpga.examples.vivado.project import TsfpgaExampleVivadoNetlistProject
 from tsfpga.module import BaseModule
-from tsfpga.vivado.build_result_checker import EqualTo, Ffs, MaximumLogicLevel, TotalLuts
+from tsfpga.vivado.build_result_checker import (
+    EqualTo,
+    Ffs,
+    LessThan,
+    MaximumLogicLevel,
+    TotalLuts,
+)
 
 if TYPE_CHECKING:
     from vunit.ui import VUnit
@@ -29,6 +35,18 @@ class Module(BaseModule):
         for _ in range(8):
             self.add_vunit_config(test=test, set_random_seed=True)
 
+        test = vunit_proj.library(self.library_name).test_bench(
+            "tb_dma_axi_write_simple_multi_channel"
+        )
+        for _ in range(4):
+            self.add_vunit_config(test=test, set_random_seed=True)
+
+        test = vunit_proj.library(self.library_name).test_bench(
+            "tb_dma_axi_write_simple_throughput"
+        )
+        for _ in range(4):
+            self.add_vunit_config(test=test, set_random_seed=True)
+
     def get_build_projects(self) -> list[TsfpgaExampleVivadoNetlistProject]:
         # The 'hdl_modules' Python package is probably not on the PYTHONPATH in most scenarios where
         # this module is used. Hence we can not import at the top of this file.
@@ -41,7 +59,7 @@ class Module(BaseModule):
 
         projects = []
 
-        def add(generics: dict, lut: int, ff: int, logic: int) -> None:
+        def add_project(generics: dict, build_result_checkers: list) -> None:
             all_generics = dict(address_width=29, stream_data_width=64, **generics)
             projects.append(
                 TsfpgaExampleVivadoNetlistProject(
@@ -53,14 +71,30 @@ class Module(BaseModule):
                     part=part,
                     top="dma_axi_write_simple_axi_lite",
                     generics=all_generics,
-                    build_result_checkers=[
-                        TotalLuts(EqualTo(lut)),
-                        Ffs(EqualTo(ff)),
-                        MaximumLogicLevel(EqualTo(logic)),
-                    ],
+                    build_result_checkers=build_result_checkers,
                 )
             )
 
+        def add(generics: dict, lut: int, ff: int, logic: int) -> None:
+            add_project(
+                generics=generics,
+                build_result_checkers=[
+                    TotalLuts(EqualTo(lut)),
+                    Ffs(EqualTo(ff)),
+                    MaximumLogicLevel(EqualTo(logic)),
+                ],
+            )
+
+        def add_feature(generics: dict, max_lut: int, max_ff: int, max_logic: int) -> None:
+            add_project(
+                generics=dict(axi_data_width=64, packet_length_beats=16384, **generics),
+                build_result_checkers=[
+                    TotalLuts(LessThan(max_lut + 1)),
+                    Ffs(LessThan(max_ff + 1)),
+                    MaximumLogicLevel(LessThan(max_logic + 1)),
+                ],
+            )
+
         add(generics={"axi_data_width": 64, "packet_length_beats": 1}, lut=156, ff=207, logic=16)
         add(generics={"axi_data_width": 64, "packet_length_beats": 16}, lut=157, ff=226, logic=12)
         add(generics={"axi_data_width": 64, "packet_length_beats": 2048}, lut=132, ff=218, logic=11)
@@ -78,4 +112,34 @@ class Module(BaseModule):
             logic=11,
         )
 
+        # The builds above have all optional features disabled, and an 'address_width' that gives
+        # no '_high' registers.
+        # Their register file, and hence their resource usage, is the same as before the optional
+        # features were added.
+        # Meaning that the checkers above make sure that a disabled feature costs nothing.
+
+        # Each optional feature enabled on its own, on top of the 16384-beat build above.
+        # These are upper bounds, derived from the counters, registers and FIFOs that each feature
+        # adds, with some margin.
+        # They guard against a feature growing out of proportion, and shall be tightened to exact
+        # values, like the builds above, when the numbers of a build are at hand.
+        add_feature(generics=dict(enable_telemetry=True), max_lut=450, max_ff=400, max_logic=14)
+        add_feature(generics=dict(enable_flush_timeout=True), max_lut=300, max_ff=330, max_logic=14)
+        add_feature(
+            generics=dict(enable_interrupt_coalescing=True), max_lut=350, max_ff=400, max_logic=14
+        )
+        add_feature(
+            generics=dict(enable_address_pipelining=True), max_lut=200, max_ff=260, max_logic=12
+        )
+        add_feature(generics=dict(max_outstanding_bursts=4), max_lut=200, max_ff=240, max_logic=12)
+        add_feature(
+            generics=dict(enable_written_address_writeback=True),
+            max_lut=450,
+            max_ff=450,
+            max_logic=14,
+        )
+        add_feature(
+            generics=dict(enable_packet_metadata=True), max_lut=600, max_ff=550, max_logic=14
+        )
+
         return projects
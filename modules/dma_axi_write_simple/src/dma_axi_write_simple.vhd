@@ -23,8 +23,9 @@
 --
 -- .. note::
 --   The packet length is a compile-time parameter.
---   It can not be changed during runtime and there is no support for writing or clearing
---   partial packets.
+--   It can not be changed during runtime.
+--   By default there is no support for writing or clearing partial packets, but see
+--   :ref:`dma_axi_write_simple_flush_timeout` below.
 --
 --   This saves a lot of resources and is part of the simple nature of this DMA core.
 --
@@ -32,6 +33,45 @@
 -- the core will perform burst splitting internally.
 --
 --
+-- .. _dma_axi_write_simple_flush_timeout:
+--
+-- Partial packet flush
+-- ____________________
+--
+-- If the ``enable_flush_timeout`` generic is set, a partial packet can be flushed to memory
+-- after a timeout.
+-- When the input ``stream`` has been idle in the middle of a packet for the number of clock
+-- cycles given by the ``flush_timeout_cycles`` register, the core will pad the packet with
+-- zero-valued ``stream`` beats until it is complete.
+-- The ``stream`` is stalled while padding.
+--
+-- The packet is then written to memory like any other packet.
+-- Meaning that ``buffer_written_address`` is still always aligned with the packet length.
+-- In order for the software to tell the padding apart from data, also set the
+-- ``enable_packet_metadata`` generic (see :ref:`dma_axi_write_simple_packet_metadata`).
+-- The metadata of each packet then holds the number of padding beats at the end of the packet.
+--
+-- This makes it possible to use a long packet length, which gives good memory performance at
+-- high data rates, while still having bounded latency when the data rate is low.
+--
+--
+-- .. _dma_axi_write_simple_interrupt_coalescing:
+--
+-- Interrupt coalescing
+-- ____________________
+--
+-- By default, the ``write_done`` interrupt triggers for every packet that is written.
+-- Also when a packet is split into multiple AXI bursts, the interrupt triggers only once the last
+-- burst of the packet has been written.
+-- At short packet lengths, this can give a very high interrupt rate.
+-- If the ``enable_interrupt_coalescing`` generic is set, the interrupt will instead trigger
+-- once the number of packets given by the ``interrupt_coalescing_packets`` register have been
+-- written, or once ``interrupt_coalescing_timeout_cycles`` clock cycles have passed since the
+-- first packet that has not yet been signaled.
+-- Whichever happens first.
+-- This gives a lower interrupt rate with a bounded latency.
+--
+--
 -- Data width conversion
 -- _____________________
 --
@@ -69,16 +109,109 @@
 -- If they are not, their stall will be propagated to the ``stream``.
 --
 -- This performance should be enough for even the most demanding applications.
--- The one-cycle overhead could theoretically be optimized away, but it is quite likely
--- that downstream AXI interconnect infrastructure has some overhead for each address
--- transaction anyway.
+-- It is quite likely that downstream AXI interconnect infrastructure has some overhead for each
+-- address transaction anyway.
 -- I.e. the one-cycle overhead in this core is probably not limiting the throughput overall.
 --
+-- If it is, however, the ``enable_address_pipelining`` generic can be set.
+-- The core will then initiate the ``AW`` transaction of the next burst while the ``W`` data of the
+-- current burst is being written, which removes the one-cycle overhead.
+-- The cost is slightly higher resource usage, and that an ``AW`` transaction might be initiated
+-- before there is ``W`` data available for it (see :ref:`dma_axi_write_simple_axi_behavior`).
+-- This generic has no effect when the packet length is one AXI beat, since that implementation
+-- has no per-packet overhead.
+--
 -- If the memory buffer is full, the ``stream`` will stall until there is space.
 -- When the software writes an updated ``buffer_read_address`` register indicating available space,
 -- the ``stream`` will start after two clock cycles.
 --
 --
+-- Telemetry
+-- _________
+--
+-- If the ``enable_telemetry`` generic is set, the core will count
+--
+-- 1. Clock cycles where the ``stream`` is stalled because the memory buffer is full.
+-- 2. Clock cycles where the ``stream`` is stalled because of ``AWREADY`` or ``WREADY``.
+-- 3. Packets written to memory.
+-- 4. The peak fill level of the memory buffer.
+--
+-- See the ``telemetry_`` registers for details.
+-- This is useful for tuning the buffer size and the choice of AXI port.
+-- The counters are not part of the core functionality, and cost additional resources.
+--
+--
+-- .. _dma_axi_write_simple_writeback:
+--
+-- Written address writeback
+-- _________________________
+--
+-- Register reads over AXI-Lite are usually very slow, compared to reading memory.
+-- If the ``enable_written_address_writeback`` generic is set, the core can write the
+-- ``buffer_written_address`` value, along with a sequence number, to a memory location given by
+-- the ``writeback_address`` register.
+-- The software can then poll this memory location instead of the register.
+--
+-- The writeback is an eight-byte AXI write that is performed after a packet has been written to
+-- memory, i.e. after its ``B`` response has been received.
+-- Meaning that the data is always in memory before the software can see the updated address.
+-- The writeback is inserted between data bursts, and uses the ``writeback_axi_id`` generic as
+-- ``AWID``, so that its ``B`` response can be told apart from the data responses.
+-- Note that this implies that the AXI port must support an ID width that can hold both IDs.
+-- The ``B`` responses are only routed by ID while a writeback is in flight.
+-- Meaning that if the writeback is not enabled in ``writeback_config``, the ``BID`` of the data
+-- responses does not matter.
+--
+-- There is only one writeback transaction in flight at a time.
+-- If more packets are written while it is in flight, only the latest address will be written
+-- once it is done.
+--
+-- The latency of the writeback is bounded, also with a continuous ``stream`` that never leaves a
+-- gap in between data bursts.
+-- Once a packet has been written, at most two new data bursts are started
+-- before the writeback.
+-- Any further data bursts are held back until the bursts that have already been started
+-- are finished and the writeback has been initiated.
+-- Meaning that the writeback waits for at most three data bursts, or four with
+-- ``enable_address_pipelining``, when ``AWREADY`` and ``WREADY`` are high and the ``stream`` does
+-- not stall.
+-- Held back bursts count as ``full_stall`` in the telemetry.
+--
+-- When the writeback is enabled, the ``write_done`` interrupt, as well as the
+-- :ref:`interrupt coalescing <dma_axi_write_simple_interrupt_coalescing>` packet count, are driven
+-- by the ``B`` response of the writeback instead of the data.
+-- Meaning that the interrupt triggers once per writeback, and that the value in memory is always
+-- up to date when the software handles the interrupt.
+--
+--
+-- .. _dma_axi_write_simple_packet_metadata:
+--
+-- Packet metadata
+-- _______________
+--
+-- If the ``enable_packet_metadata`` generic is set, the core records a timestamp, a sequence
+-- number and the number of padding beats (see :ref:`dma_axi_write_simple_flush_timeout`) for
+-- each packet.
+-- The timestamp is the value of a free-running 64-bit clock cycle counter at the time when the
+-- first beat of the packet was accepted on the ``stream`` interface.
+-- This gives a much more precise arrival time than what the software can measure when it receives
+-- the data, which is useful for correlating the data with other sources and for profiling the
+-- latency of the data path.
+--
+-- The values are stored in a FIFO with ``packet_metadata_fifo_depth`` entries, which the software
+-- reads through the ``packet_metadata_`` registers, one packet at a time.
+-- Entries are ordered like the packets in the memory buffer.
+-- Note that an entry is added as soon as the last beat of the packet has been accepted, i.e. before
+-- the packet has been written to memory.
+-- The software shall only read the entries of packets that it has received.
+--
+-- If the FIFO is full when a packet ends, the entry of that packet is dropped.
+-- The sequence number is incremented for every packet, regardless, so that the software can
+-- detect a dropped entry from a gap in the sequence numbers.
+--
+--
+-- .. _dma_axi_write_simple_axi_behavior:
+--
 -- AXI behavior
 -- ____________
 --
@@ -87,11 +220,31 @@
 -- 1. AXI bursts of the maximum length possible will be used.
 --
 -- 2. The ``AW`` transaction is only initiated once we have at least one ``W`` beat available.
+--    Unless ``enable_address_pipelining`` is set, in which case it might be initiated
+--    during the previous burst.
 --
 -- 3. ``BREADY`` is always high.
 --
+-- 4. All transactions use the same ID, given by the ``axi_id`` generic.
+--    Except for the optional :ref:`written address writeback <dma_axi_write_simple_writeback>`.
+--
 -- This gives very good AXI performance.
 --
+-- Outstanding transactions
+-- ~~~~~~~~~~~~~~~~~~~~~~~~
+--
+-- By default, the core will initiate new bursts as long as there is data and buffer space
+-- available, regardless of how many write responses are pending.
+-- On AXI paths with high latency, this is what enables full throughput.
+-- The ``buffer_written_address`` register is updated, and the ``write_done`` interrupt triggers,
+-- only once the ``B`` responses for all the bursts of a packet have been received.
+-- Since all transactions use the same ID, the responses arrive in the same order as the bursts.
+--
+-- The ``max_outstanding_bursts`` generic can be set to limit the number of bursts that have been
+-- initiated on the ``AW`` channel but not yet received a ``B`` response.
+-- This can be useful if the downstream AXI slave has a limited transaction capability, and
+-- stalling the ``AW`` channel would block other masters.
+--
 -- W channel block
 -- ~~~~~~~~~~~~~~~
 --
@@ -113,8 +266,8 @@
 -- ~~~~
 --
 -- Setting the ``enable_axi3`` generic will make the core compliant with AXI3 instead of AXI4.
--- The core does not use any of the ID fields (``AWID``, ``WID``, ``BID``) so the only difference
--- is the burst length limitation.
+-- ``WID`` is assigned the same static value as ``AWID``, so the only difference is the
+-- burst length limitation.
 -- -------------------------------------------------------------------------------------------------
 
 library ieee;
@@ -130,8 +283,11 @@ use axi_lite.axi_lite_pkg.all;
 library common;
 use common.types_pkg.all;
 
+library fifo;
+
 library math;
 use math.math_pkg.is_power_of_two;
+use math.math_pkg.num_bits_needed;
 
 library register_file;
 use register_file.register_file_pkg.all;
@@ -147,6 +303,7 @@ entity dma_axi_write_simple is
   generic (
     -- The width of the AXI AWADDR field as well as all the ring buffer addresses
     -- handled internally.
+    -- If greater than 32, the upper address bits are handled by the '_high' registers.
     address_width : axi_address_width_t;
     -- The data width of the 'stream' interface.
     stream_data_width : axi_data_width_t;
@@ -162,7 +319,36 @@ entity dma_axi_write_simple is
     -- accumulated data.
     packet_length_beats : positive;
     -- Enable AXI3 instead of AXI4, with the limitations that this implies.
-    enable_axi3 : boolean
+    enable_axi3 : boolean;
+    -- Enable the 'telemetry_' counter registers, at the cost of additional resources.
+    enable_telemetry : boolean;
+    -- Enable flushing of partial packets after a timeout, given by the
+    -- 'flush_timeout_cycles' register.
+    enable_flush_timeout : boolean;
+    -- Enable coalescing of 'write_done' interrupts, given by the
+    -- 'interrupt_coalescing_' registers.
+    enable_interrupt_coalescing : boolean;
+    -- Initiate the AW transaction of the next AXI burst during the current burst,
+    -- which removes the one-cycle-per-burst overhead.
+    enable_address_pipelining : boolean;
+    -- The maximum number of AXI bursts that can be outstanding, i.e. that are waiting for a
+    -- 'B' response.
+    -- Set to zero for no limit.
+    max_outstanding_bursts : natural;
+    -- Static value for the AXI 'AWID' field and, in AXI3 mode, the 'WID' field.
+    axi_id : natural;
+    -- Write the 'buffer_written_address' value to memory every time it is updated, given by the
+    -- 'writeback_' registers.
+    enable_written_address_writeback : boolean;
+    -- The AXI ID used for the writeback transactions.
+    -- Must be different from 'axi_id'.
+    writeback_axi_id : natural;
+    -- Record a timestamp and a sequence number for each packet, that can be read through the
+    -- 'packet_metadata_' registers.
+    enable_packet_metadata : boolean;
+    -- The number of packets that the metadata FIFO can hold.
+    -- Must be a power of two.
+    packet_metadata_fifo_depth : positive
   );
   port (
     clk : in std_ulogic;
@@ -194,13 +380,35 @@ architecture a of dma_axi_write_simple is
   -- Signals.
   signal interrupt_sources : register_t := (others => '0');
 
+  -- A whole packet has been written to memory.
+  signal write_done : std_ulogic := '0';
+  -- The number of packets that shall now be signaled to the software with the 'write_done'
+  -- interrupt.
+  -- Given by 'write_done', except when the written address writeback is used, in which case it is
+  -- given by the response of the writeback.
+  signal num_packets_done : u_unsigned(register_width - 1 downto 0) := (others => '0');
+
+  -- Used by the written address writeback, in order to get a slot on the AXI bus.
+  -- A data burst has been started, and no new data burst shall be started.
+  signal data_burst_started, hold_data_bursts : std_ulogic := '0';
+
   signal ring_buffer_status : ring_buffer_write_simple_status_t := (
     ring_buffer_write_simple_status_idle_no_error
   );
 
+  -- The 'stream' after optional padding of partial packets.
+  signal input_ready, input_valid : std_ulogic := '0';
+  -- The current 'input' beat is padding of a partial packet, not 'stream' data.
+  signal is_padding : std_ulogic := '0';
+  signal input_data : std_ulogic_vector(stream_data'range) := (others => '0');
+
   signal axi_ready, axi_valid : std_ulogic := '0';
   signal axi_data : std_ulogic_vector(axi_data_width - 1 downto 0) := (others => '0');
 
+  -- The AXI bus for the stream data, before the optional written address writeback.
+  signal data_m2s : axi_write_m2s_t := axi_write_m2s_init;
+  signal data_s2m : axi_write_s2m_t := axi_write_s2m_init;
+
 begin
 
   ------------------------------------------------------------------------------
@@ -229,10 +437,30 @@ begin
     report "Packet length must be a power-of-two number of AXI beats."
     severity failure;
 
+  assert axi_id < 2 ** axi_id_sz
+    report "AXI ID does not fit in the ID field."
+    severity failure;
+
+  assert not enable_written_address_writeback or writeback_axi_id < 2 ** axi_id_sz
+    report "Writeback AXI ID does not fit in the ID field."
+    severity failure;
+
+  assert not enable_written_address_writeback or writeback_axi_id /= axi_id
+    report "Writeback AXI ID must be different from the data AXI ID."
+    severity failure;
+
+  assert (
+    not enable_packet_metadata
+    or packet_metadata_fifo_depth <= dma_axi_write_simple_packet_metadata_status_level_t'high
+  )
+    report "Packet metadata FIFO depth does not fit in the level register field."
+    severity failure;
+
 
   ------------------------------------------------------------------------------
   interrupt_register_block : block
     signal clear, status : register_t := (others => '0');
+    signal write_done_interrupt : std_ulogic := '0';
   begin
 
     ------------------------------------------------------------------------------
@@ -248,10 +476,53 @@ begin
         trigger => interrupt
       );
 
-    interrupt_sources(dma_axi_write_simple_interrupt_status_write_done) <= (
-      axi_write_m2s.b.ready and axi_write_s2m.b.valid
-    );
+    ------------------------------------------------------------------------------
+    interrupt_coalescing_gen : if enable_interrupt_coalescing generate
+
+      ------------------------------------------------------------------------------
+      coalesce_write_done : process
+        subtype counter_t is u_unsigned(register_width - 1 downto 0);
+        variable num_packets_pending, num_cycles_pending : counter_t := (others => '0');
+        variable num_packets_limit, num_cycles_limit : counter_t := (others => '0');
+      begin
+        wait until rising_edge(clk);
+
+        num_packets_limit := u_unsigned(regs_down.interrupt_coalescing_packets);
+        num_cycles_limit := u_unsigned(regs_down.interrupt_coalescing_timeout_cycles);
+
+        write_done_interrupt <= '0';
+
+        if num_packets_pending /= 0 then
+          num_cycles_pending := num_cycles_pending + 1;
+        end if;
+
+        num_packets_pending := num_packets_pending + num_packets_done;
+
+        -- Note that a packet limit of zero or one means that every packet is signaled.
+        -- A timeout of zero means that there is no timeout.
+        if num_packets_pending /= 0 and (
+          num_packets_pending >= num_packets_limit
+          or (num_cycles_limit /= 0 and num_cycles_pending >= num_cycles_limit)
+        ) then
+          write_done_interrupt <= '1';
+
+          num_packets_pending := (others => '0');
+          num_cycles_pending := (others => '0');
+        end if;
+      end process;
+
+    ------------------------------------------------------------------------------
+    else generate
+
+      -- Trigger for every packet, as described in the documentation.
+      -- Same unit as the packet count of the coalescing above.
+      write_done_interrupt <= to_sl(num_packets_done /= 0);
+
+    end generate;
+
+    interrupt_sources(dma_axi_write_simple_interrupt_status_write_done) <= write_done_interrupt;
 
+    -- Note that this includes the response of the optional written address writeback.
     interrupt_sources(dma_axi_write_simple_interrupt_status_write_error) <= (
       axi_write_m2s.b.ready
       and axi_write_s2m.b.valid
@@ -277,6 +548,155 @@ begin
   end block;
 
 
+  ------------------------------------------------------------------------------
+  flush_timeout_gen : if enable_flush_timeout generate
+    signal packet_beat_index : natural range 0 to packet_length_beats - 1 := 0;
+    signal idle_cycles : u_unsigned(register_width - 1 downto 0) := (others => '0');
+  begin
+
+    ------------------------------------------------------------------------------
+    pad_partial_packet : process
+      variable flush_timeout_cycles : u_unsigned(register_width - 1 downto 0) := (
+        others => '0'
+      );
+    begin
+      wait until rising_edge(clk);
+
+      flush_timeout_cycles := u_unsigned(regs_down.flush_timeout_cycles);
+
+      if input_ready and input_valid then
+        if packet_beat_index = packet_length_beats - 1 then
+          packet_beat_index <= 0;
+          is_padding <= '0';
+        else
+          packet_beat_index <= packet_beat_index + 1;
+        end if;
+      end if;
+
+      -- Count only while we are stuck in the middle of a packet.
+      -- Any incoming data, or the start of padding, restarts the count.
+      if stream_valid or is_padding or to_sl(packet_beat_index = 0) then
+        idle_cycles <= (others => '0');
+      else
+        idle_cycles <= idle_cycles + 1;
+
+        -- A value of zero in the register means that flushing is disabled.
+        if flush_timeout_cycles /= 0 and idle_cycles >= flush_timeout_cycles - 1 then
+          is_padding <= '1';
+        end if;
+      end if;
+    end process;
+
+    input_valid <= stream_valid or is_padding;
+    input_data <= (others => '0') when is_padding else stream_data;
+    stream_ready <= input_ready and not is_padding;
+
+  ------------------------------------------------------------------------------
+  else generate
+
+    stream_ready <= input_ready;
+    input_valid <= stream_valid;
+    input_data <= stream_data;
+
+  end generate;
+
+
+  ------------------------------------------------------------------------------
+  packet_metadata_gen : if enable_packet_metadata generate
+    subtype timestamp_t is u_unsigned(2 * register_width - 1 downto 0);
+    subtype sequence_number_t is u_unsigned(register_width - 1 downto 0);
+    -- The first beat of a packet is always data, so at most all but one beat is padding.
+    constant num_padding_beats_width : positive := num_bits_needed(packet_length_beats - 1);
+    subtype num_padding_beats_t is u_unsigned(num_padding_beats_width - 1 downto 0);
+
+    constant metadata_width : positive := (
+      timestamp_t'length + sequence_number_t'length + num_padding_beats_t'length
+    );
+
+    signal timestamp, packet_timestamp : timestamp_t := (others => '0');
+    signal sequence_number : sequence_number_t := (others => '0');
+    signal num_padding_beats : num_padding_beats_t := (others => '0');
+    signal packet_beat_index : natural range 0 to packet_length_beats - 1 := 0;
+
+    signal write_timestamp : timestamp_t := (others => '0');
+    signal write_num_padding_beats : num_padding_beats_t := (others => '0');
+
+    signal write_valid : std_ulogic := '0';
+    signal write_data, read_data : std_ulogic_vector(metadata_width - 1 downto 0) := (
+      others => '0'
+    );
+  begin
+
+    ------------------------------------------------------------------------------
+    count : process
+    begin
+      wait until rising_edge(clk);
+
+      timestamp <= timestamp + 1;
+
+      if input_ready and input_valid then
+        if packet_beat_index = 0 then
+          packet_timestamp <= timestamp;
+        end if;
+
+        if packet_beat_index = packet_length_beats - 1 then
+          sequence_number <= sequence_number + 1;
+          num_padding_beats <= (others => '0');
+          packet_beat_index <= 0;
+        else
+          num_padding_beats <= num_padding_beats + to_int(is_padding);
+          packet_beat_index <= packet_beat_index + 1;
+        end if;
+      end if;
+    end process;
+
+    -- The entry is written when the last beat of the packet is accepted, since the padding is not
+    -- known before that.
+    -- Note that the entry is dropped if the FIFO is full.
+    write_valid <= (
+      input_ready and input_valid and to_sl(packet_beat_index = packet_length_beats - 1)
+    );
+
+    -- With a packet length of one beat, the first beat is also the last.
+    write_timestamp <= timestamp when packet_beat_index = 0 else packet_timestamp;
+    write_num_padding_beats <= num_padding_beats + to_int(is_padding);
+
+    write_data <= std_ulogic_vector(write_num_padding_beats & sequence_number & write_timestamp);
+
+
+    ------------------------------------------------------------------------------
+    fifo_inst : entity fifo.fifo
+      generic map (
+        width => metadata_width,
+        depth => packet_metadata_fifo_depth
+      )
+      port map (
+        clk => clk,
+        level => regs_up.packet_metadata_status.level,
+        --
+        write_ready => open,
+        write_valid => write_valid,
+        write_data => write_data,
+        --
+        read_ready => regs_down.packet_metadata_control.pop,
+        read_valid => open,
+        read_data => read_data
+      );
+
+    regs_up.packet_metadata_timestamp <= read_data(register_width - 1 downto 0);
+    regs_up.packet_metadata_timestamp_high <= (
+      read_data(2 * register_width - 1 downto register_width)
+    );
+    regs_up.packet_metadata_sequence_number <= read_data(
+      3 * register_width - 1 downto 2 * register_width
+    );
+    regs_up.packet_metadata_num_padding_beats(num_padding_beats_t'range) <= (
+      read_data(read_data'high downto 3 * register_width)
+    );
+
+  end generate;
+
+
   ------------------------------------------------------------------------------
   width_conversion_gen : if stream_data_width /= axi_data_width generate
 
@@ -289,9 +709,9 @@ begin
       port map (
         clk => clk,
         --
-        input_ready => stream_ready,
-        input_valid => stream_valid,
-        input_data => stream_data,
+        input_ready => input_ready,
+        input_valid => input_valid,
+        input_data => input_data,
         --
         output_ready => axi_ready,
         output_valid => axi_valid,
@@ -301,9 +721,9 @@ begin
   ------------------------------------------------------------------------------
   else generate
 
-    stream_ready <= axi_ready;
-    axi_valid <= stream_valid;
-    axi_data <= stream_data;
+    input_ready <= axi_ready;
+    axi_valid <= input_valid;
+    axi_data <= input_data;
 
   end generate;
 
@@ -343,7 +763,15 @@ begin
     constant axi_burst_length_bytes : positive := axi_burst_length_beats * axi_data_width_bytes;
 
     signal segment_ready, segment_valid : std_ulogic := '0';
+    -- Before the optional limitation of outstanding bursts.
+    signal ring_buffer_segment_valid : std_ulogic := '0';
     signal segment_address : u_unsigned(address_width - 1 downto 0) := (others => '0');
+
+    -- For telemetry.
+    -- Input data is available but stalled, either because the buffer is full or because of
+    -- the AXI bus.
+    signal full_stall, axi_stall : std_ulogic := '0';
+    signal buffer_fill_bytes : u_unsigned(address_width - 1 downto 0) := (others => '0');
   begin
 
     ------------------------------------------------------------------------------
@@ -363,9 +791,19 @@ begin
       signal buffer_start_address, buffer_end_address, buffer_written_address, buffer_read_address :
         u_unsigned(address_width - 1 downto 0) := (others => '0');
 
+      subtype buffer_written_address_low_range is
+        natural range minimum(address_width, register_width) - 1 downto 0;
+
+      -- Addresses are split over a low and a high register, in order to support
+      -- 'address_width' greater than 32.
+      function to_address(low, high : register_t) return u_unsigned is
+        constant full : std_ulogic_vector(2 * register_width - 1 downto 0) := high & low;
+      begin
+        return u_unsigned(full(address_width - 1 downto 0));
+      end function;
+
       -- If we are doing burst splitting, not every 'BVALID' marks the end of a packet.
       signal is_last_burst_in_packet : std_ulogic := '0';
-      signal write_done : std_ulogic := '0';
     begin
 
       ------------------------------------------------------------------------------
@@ -389,7 +827,7 @@ begin
           buffer_read_address => buffer_read_address,
           --
           segment_ready => segment_ready,
-          segment_valid => segment_valid,
+          segment_valid => ring_buffer_segment_valid,
           segment_address => segment_address,
           --
           write_done => write_done,
@@ -397,17 +835,31 @@ begin
           status => ring_buffer_status
         );
 
-      buffer_start_address <= u_unsigned(
-        regs_down.buffer_start_address(buffer_start_address'range)
+      buffer_start_address <= to_address(
+        low=>regs_down.buffer_start_address, high=>regs_down.buffer_start_address_high
+      );
+      buffer_end_address <= to_address(
+        low=>regs_down.buffer_end_address, high=>regs_down.buffer_end_address_high
+      );
+      buffer_read_address <= to_address(
+        low=>regs_down.buffer_read_address, high=>regs_down.buffer_read_address_high
       );
-      buffer_end_address <= u_unsigned(regs_down.buffer_end_address(buffer_end_address'range));
-      buffer_read_address <= u_unsigned(regs_down.buffer_read_address(buffer_read_address'range));
 
-      regs_up.buffer_written_address(buffer_written_address'range) <= std_logic_vector(
-        buffer_written_address
+      regs_up.buffer_written_address(buffer_written_address_low_range) <= std_logic_vector(
+        buffer_written_address(buffer_written_address_low_range)
       );
 
 
+      ------------------------------------------------------------------------------
+      buffer_written_address_high_gen : if address_width > register_width generate
+
+        regs_up.buffer_written_address_high(address_width - register_width - 1 downto 0) <= (
+          std_logic_vector(buffer_written_address(address_width - 1 downto register_width))
+        );
+
+      end generate;
+
+
       ------------------------------------------------------------------------------
       assign_last_inst : entity common.assign_last
         generic map (
@@ -416,27 +868,84 @@ begin
         port map (
           clk => clk,
           --
-          ready => axi_write_m2s.b.ready,
-          valid => axi_write_s2m.b.valid,
+          ready => data_m2s.b.ready,
+          valid => data_s2m.b.valid,
           last => is_last_burst_in_packet
         );
 
       write_done <= (
-        axi_write_m2s.b.ready and axi_write_s2m.b.valid and is_last_burst_in_packet
+        data_m2s.b.ready and data_s2m.b.valid and is_last_burst_in_packet
+      );
+
+      -- The number of bytes between the read and written pointers, taking wrap-around into
+      -- account.
+      buffer_fill_bytes <= (
+        buffer_written_address - buffer_read_address
+        when buffer_written_address >= buffer_read_address
+        else buffer_written_address + (buffer_end_address - buffer_start_address)
+          - buffer_read_address
       );
 
     end block;
 
-    -- Note that no AWID is set. Hence no WID has to be set in AXI3 mode either.
+    ------------------------------------------------------------------------------
+    outstanding_gen : if max_outstanding_bursts > 0 generate
+      signal num_outstanding_bursts : natural range 0 to max_outstanding_bursts := 0;
+    begin
+
+      ------------------------------------------------------------------------------
+      count_outstanding : process
+        variable num_outstanding_bursts_next : natural range 0 to max_outstanding_bursts := 0;
+      begin
+        wait until rising_edge(clk);
+
+        num_outstanding_bursts_next := num_outstanding_bursts;
+
+        -- One 'segment' is popped per AW transaction.
+        -- Use the 'valid' that is not gated below.
+        if segment_ready and ring_buffer_segment_valid then
+          num_outstanding_bursts_next := num_outstanding_bursts_next + 1;
+        end if;
+
+        if data_m2s.b.ready and data_s2m.b.valid then
+          num_outstanding_bursts_next := num_outstanding_bursts_next - 1;
+        end if;
+
+        num_outstanding_bursts <= num_outstanding_bursts_next;
+      end process;
+
+      -- Do not let a new burst start if we are at the limit.
+      -- This will count as a 'full_stall' in the telemetry.
+      segment_valid <= (
+        ring_buffer_segment_valid
+        and to_sl(num_outstanding_bursts < max_outstanding_bursts)
+        and not hold_data_bursts
+      );
+
+
+    ------------------------------------------------------------------------------
+    else generate
+
+      segment_valid <= ring_buffer_segment_valid and not hold_data_bursts;
+
+    end generate;
+
+    -- One 'segment' is popped per burst.
+    -- Since the gating above only changes right after a pop, it never retracts a 'valid'
+    -- on the AXI bus.
+    data_burst_started <= segment_ready and segment_valid;
 
-    axi_write_m2s.aw.len <= to_len(burst_length_beats=>axi_burst_length_beats);
-    axi_write_m2s.aw.size <= to_size(data_width_bits=>axi_data_width);
-    axi_write_m2s.aw.burst <= axi_a_burst_incr;
+    data_m2s.aw.id <= to_unsigned(axi_id, data_m2s.aw.id'length);
+    -- Only used in AXI3 mode.
+    data_m2s.w.id <= to_unsigned(axi_id, data_m2s.w.id'length);
+    data_m2s.aw.len <= to_len(burst_length_beats=>axi_burst_length_beats);
+    data_m2s.aw.size <= to_size(data_width_bits=>axi_data_width);
+    data_m2s.aw.burst <= axi_a_burst_incr;
 
-    axi_write_m2s.w.data(axi_data'range) <= axi_data;
-    axi_write_m2s.w.strb <= to_strb(data_width=>axi_data_width);
+    data_m2s.w.data(axi_data'range) <= axi_data;
+    data_m2s.w.strb <= to_strb(data_width=>axi_data_width);
 
-    axi_write_m2s.b.ready <= '1';
+    data_m2s.b.ready <= '1';
 
 
     ------------------------------------------------------------------------------
@@ -474,16 +983,19 @@ begin
           input_ready => merged_ready,
           input_valid => merged_valid,
           --
-          output_ready(0) => axi_write_s2m.aw.ready,
-          output_ready(1) => axi_write_s2m.w.ready,
-          output_valid(0) => axi_write_m2s.aw.valid,
-          output_valid(1) => axi_write_m2s.w.valid
+          output_ready(0) => data_s2m.aw.ready,
+          output_ready(1) => data_s2m.w.ready,
+          output_valid(0) => data_m2s.aw.valid,
+          output_valid(1) => data_m2s.w.valid
         );
 
-      axi_write_m2s.aw.addr(segment_address'range) <= segment_address;
+      data_m2s.aw.addr(segment_address'range) <= segment_address;
 
       -- Packet length one beat -> it is always the last beat.
-      axi_write_m2s.w.last <= '1';
+      data_m2s.w.last <= '1';
+
+      full_stall <= axi_valid and not segment_valid;
+      axi_stall <= axi_valid and segment_valid and not axi_ready;
 
 
     ------------------------------------------------------------------------------
@@ -493,17 +1005,23 @@ begin
       signal state : state_t := wait_for_start_condition;
 
       signal axi_last : std_ulogic := '0';
+
+      -- Used with address pipelining.
+      -- The AW transaction of the next burst has been initiated.
+      signal next_burst_addressed : std_ulogic := '0';
     begin
 
       ------------------------------------------------------------------------------
       address_handshaking : process
+        -- Includes an AW transaction of the next burst that is initiated in this same clock cycle.
+        variable next_burst_addressed_v : std_ulogic := '0';
       begin
         wait until rising_edge(clk);
 
         segment_ready <= '0';
 
-        if axi_write_s2m.aw.ready then
-          axi_write_m2s.aw.valid <= '0';
+        if data_s2m.aw.ready then
+          data_m2s.aw.valid <= '0';
         end if;
 
         case state is
@@ -517,11 +1035,11 @@ begin
             --    Meaning, the user has initiated the ring buffer and it is not full.
             -- 3. The previous AW transaction is done, since we simply assert AWVALID and do
             --    not wait for a transaction before proceeding in the state machine.
-            if axi_valid and segment_valid and not axi_write_m2s.aw.valid then
-              axi_write_m2s.aw.valid <= '1';
+            if axi_valid and segment_valid and not data_m2s.aw.valid then
+              data_m2s.aw.valid <= '1';
               -- Sample the address since we will pop the 'segment' word straight away, whereas
               -- we don't know when the 'AW' transaction will happen.
-              axi_write_m2s.aw.addr(segment_address'range) <= segment_address;
+              data_m2s.aw.addr(segment_address'range) <= segment_address;
 
               -- Since we spend at least one clock cycle in the other state, it is safe to pop like
               -- this and then look at 'segment_valid' as soon as we return to this state again.
@@ -531,12 +1049,45 @@ begin
             end if;
 
           when let_data_pass =>
+            next_burst_addressed_v := next_burst_addressed;
+
+            -- With address pipelining, initiate the AW transaction of the next burst while
+            -- the current burst is being written.
+            -- Same conditions as above, except that the stream data we see belongs to the current
+            -- burst.
+            -- Note that 'segment_valid' is not updated until two clock cycles after we pop,
+            -- hence the check of 'segment_ready'.
+            if (
+              enable_address_pipelining
+              and next_burst_addressed = '0'
+              and segment_valid = '1'
+              and segment_ready = '0'
+              and data_m2s.aw.valid = '0'
+            ) then
+              data_m2s.aw.valid <= '1';
+              data_m2s.aw.addr(segment_address'range) <= segment_address;
+
+              segment_ready <= '1';
+              next_burst_addressed_v := '1';
+            end if;
+
             -- Use the 'ready' and 'valid' that are not gated by the 'state'.
             -- Saves a little bit of critical path.
-            if axi_write_s2m.w.ready and axi_valid and axi_last then
-              state <= wait_for_start_condition;
+            -- Note that the AW transaction of the next burst might have been initiated above, on
+            -- the same clock edge as the last beat.
+            -- If we went back to the other state in that case, the data of the next burst would
+            -- be held until yet another segment is available, which might never happen.
+            if data_s2m.w.ready and axi_valid and axi_last then
+              if next_burst_addressed_v then
+                -- Go straight on to the next burst, without any overhead.
+                next_burst_addressed_v := '0';
+              else
+                state <= wait_for_start_condition;
+              end if;
             end if;
 
+            next_burst_addressed <= next_burst_addressed_v;
+
         end case;
       end process;
 
@@ -556,13 +1107,307 @@ begin
           last => axi_last
         );
 
-      axi_write_m2s.w.valid <= axi_valid and to_sl(state = let_data_pass);
-      axi_write_m2s.w.last <= axi_last;
+      data_m2s.w.valid <= axi_valid and to_sl(state = let_data_pass);
+      data_m2s.w.last <= axi_last;
+
+      axi_ready <= data_s2m.w.ready and to_sl(state = let_data_pass);
+
+      -- Note that the one-cycle overhead per packet, when we are about to start a new burst,
+      -- is not counted as a stall.
+      full_stall <= axi_valid and not segment_valid and to_sl(state = wait_for_start_condition);
+      axi_stall <= axi_valid and not axi_ready and (
+        to_sl(state = let_data_pass) or (segment_valid and data_m2s.aw.valid)
+      );
+
+    end generate;
+
+
+    ------------------------------------------------------------------------------
+    telemetry_gen : if enable_telemetry generate
+      subtype counter_t is u_unsigned(register_width - 1 downto 0);
+      signal full_stall_cycles, axi_stall_cycles, packets_written, peak_fill : counter_t := (
+        others => '0'
+      );
+    begin
+
+      ------------------------------------------------------------------------------
+      count : process
+        -- Saturate instead of wrapping around, so that a read value is never misleading.
+        function increment(value : counter_t) return counter_t is
+        begin
+          if value = counter_t'(others => '1') then
+            return value;
+          end if;
+
+          return value + 1;
+        end function;
+
+        variable fill : counter_t := (others => '0');
+      begin
+        wait until rising_edge(clk);
+
+        fill := resize(buffer_fill_bytes, fill'length);
 
-      axi_ready <= axi_write_s2m.w.ready and to_sl(state = let_data_pass);
+        if full_stall then
+          full_stall_cycles <= increment(full_stall_cycles);
+        end if;
+
+        if axi_stall then
+          axi_stall_cycles <= increment(axi_stall_cycles);
+        end if;
+
+        if write_done then
+          packets_written <= increment(packets_written);
+        end if;
+
+        if fill > peak_fill then
+          peak_fill <= fill;
+        end if;
+
+        if regs_down.telemetry_control.clear then
+          full_stall_cycles <= (others => '0');
+          axi_stall_cycles <= (others => '0');
+          packets_written <= (others => '0');
+          peak_fill <= fill;
+        end if;
+      end process;
+
+      regs_up.telemetry_full_stall_cycles <= std_logic_vector(full_stall_cycles);
+      regs_up.telemetry_axi_stall_cycles <= std_logic_vector(axi_stall_cycles);
+      regs_up.telemetry_packets_written <= std_logic_vector(packets_written);
+      regs_up.telemetry_peak_fill <= std_logic_vector(peak_fill);
 
     end generate;
 
   end block;
 
+
+  ------------------------------------------------------------------------------
+  writeback_gen : if enable_written_address_writeback generate
+    -- The value to write is 64 bits, which might be more than one AXI beat.
+    constant writeback_width : positive := 2 * register_width;
+    constant writeback_num_beats : positive := maximum(1, writeback_width / axi_data_width);
+    -- The number of bits of the value that are written in each beat.
+    constant writeback_beat_width : positive := minimum(axi_data_width, writeback_width);
+
+    -- The number of data bursts that may be started while a writeback is pending.
+    -- After that, new data bursts are held back until the writeback has been started.
+    constant max_bursts_while_pending : positive := 2;
+
+    type state_t is (idle, write, wait_for_response);
+    signal state : state_t := idle;
+
+    -- A packet has been written, that has not yet been signaled with a writeback.
+    signal writeback_pending : std_ulogic := '0';
+    signal num_bursts_while_pending : natural range 0 to max_bursts_while_pending := 0;
+    -- The data bus is in the middle of a 'W' burst.
+    signal data_w_in_burst : std_ulogic := '0';
+    -- Data 'AW' transactions minus finished data 'W' bursts.
+    -- The core initiates at most one pipelined 'AW' ahead of the 'W' data, and the 'W' data of at
+    -- most one burst can be accepted before its 'AW'.
+    signal num_data_bursts_unwritten : integer range -1 to 2 := 0;
+
+    signal sequence_number : u_unsigned(register_width - 1 downto 0) := (others => '0');
+    -- The sequence number of the writeback that is in flight.
+    signal writeback_sequence_number : u_unsigned(register_width - 1 downto 0) := (
+      others => '0'
+    );
+    -- The sequence number of the last packet that has been signaled with 'num_packets_done'.
+    signal signaled_sequence_number : u_unsigned(register_width - 1 downto 0) := (
+      others => '0'
+    );
+
+    -- The 'B' response of the writeback.
+    -- Responses are routed by ID only while a writeback is in flight, so that an interconnect that
+    -- truncates or remaps 'BID' does not swallow the data responses when no writeback is used.
+    signal writeback_b_valid : std_ulogic := '0';
+
+    signal writeback_m2s : axi_write_m2s_t := axi_write_m2s_init;
+    -- Shifted down as beats are written.
+    signal writeback_word : std_ulogic_vector(writeback_width - 1 downto 0) := (others => '0');
+    signal writeback_beat_index : natural range 0 to writeback_num_beats - 1 := 0;
+  begin
+
+    ------------------------------------------------------------------------------
+    write_to_memory : process
+      variable writeback_address_full : std_ulogic_vector(2 * register_width - 1 downto 0) := (
+        others => '0'
+      );
+      variable writeback_address : u_unsigned(address_width - 1 downto 0) := (others => '0');
+    begin
+      wait until rising_edge(clk);
+
+      writeback_address_full := regs_down.writeback_address_high & regs_down.writeback_address;
+      writeback_address := u_unsigned(writeback_address_full(writeback_address'range));
+
+      if data_m2s.w.valid and data_s2m.w.ready then
+        data_w_in_burst <= not data_m2s.w.last;
+      end if;
+
+      num_data_bursts_unwritten <= (
+        num_data_bursts_unwritten
+        + to_int(data_m2s.aw.valid and data_s2m.aw.ready)
+        - to_int(data_m2s.w.valid and data_s2m.w.ready and data_m2s.w.last)
+      );
+
+      if write_done then
+        writeback_pending <= '1';
+        sequence_number <= sequence_number + 1;
+      end if;
+
+      if regs_down.writeback_config.enable = '0' then
+        num_bursts_while_pending <= 0;
+      elsif (
+        writeback_pending = '1'
+        and data_burst_started = '1'
+        and num_bursts_while_pending < max_bursts_while_pending
+      ) then
+        num_bursts_while_pending <= num_bursts_while_pending + 1;
+      end if;
+
+      -- Signal packets to the software only once the written address is in memory.
+      -- Otherwise, the software could get the interrupt, read a stale value from memory and then
+      -- wait for an interrupt that never comes.
+      num_packets_done <= (others => '0');
+
+      if regs_down.writeback_config.enable = '0' then
+        -- No writeback, so signal the packets as soon as they have been written.
+        num_packets_done <= sequence_number - signaled_sequence_number;
+        signaled_sequence_number <= sequence_number;
+
+      elsif writeback_b_valid then
+        -- All packets that are included in this writeback.
+        num_packets_done <= writeback_sequence_number - signaled_sequence_number;
+        signaled_sequence_number <= writeback_sequence_number;
+      end if;
+
+      case state is
+        when idle =>
+          -- Start only in between data bursts.
+          -- Meaning, every data 'AW' transaction has its 'W' burst finished, and vice versa.
+          -- Data 'AW' or 'W' transactions can not happen this clock cycle, since the 'valid's are
+          -- low, and they are blocked from the next clock cycle, see below.
+          if (
+            regs_down.writeback_config.enable = '1'
+            and writeback_pending = '1'
+            and num_data_bursts_unwritten = 0
+            and data_w_in_burst = '0'
+            and data_m2s.aw.valid = '0'
+            and data_m2s.w.valid = '0'
+          ) then
+            -- Sample the values now, so that we always write the latest.
+            -- Any packet that is written after this will trigger a new writeback.
+            writeback_word <= std_ulogic_vector(sequence_number) & regs_up.buffer_written_address;
+            writeback_sequence_number <= sequence_number;
+            writeback_pending <= write_done;
+            num_bursts_while_pending <= 0;
+
+            writeback_m2s.aw.valid <= '1';
+            writeback_m2s.aw.addr(writeback_address'range) <= writeback_address;
+
+            writeback_m2s.w.valid <= '1';
+            writeback_beat_index <= 0;
+
+            state <= write;
+          end if;
+
+        when write =>
+          if axi_write_s2m.aw.ready then
+            writeback_m2s.aw.valid <= '0';
+          end if;
+
+          if writeback_m2s.w.valid and axi_write_s2m.w.ready then
+            if writeback_beat_index = writeback_num_beats - 1 then
+              writeback_m2s.w.valid <= '0';
+            else
+              writeback_beat_index <= writeback_beat_index + 1;
+              writeback_word <= std_ulogic_vector(
+                shift_right(u_unsigned(writeback_word), writeback_beat_width)
+              );
+            end if;
+          end if;
+
+          if (
+            (writeback_m2s.aw.valid = '0' or axi_write_s2m.aw.ready = '1')
+            and writeback_m2s.w.valid = '0'
+          ) then
+            -- Done with the bus, release it for data bursts.
+            state <= wait_for_response;
+          end if;
+
+          -- The response can come before we have had time to change state above.
+          if writeback_b_valid then
+            state <= idle;
+          end if;
+
+        when wait_for_response =>
+          if writeback_b_valid then
+            state <= idle;
+          end if;
+
+      end case;
+    end process;
+
+    -- With a continuous stream, and especially with address pipelining, there might never be a
+    -- gap in between data bursts.
+    -- So make one, once a few bursts have been started while the writeback has been pending.
+    -- The data bursts that have already been started will finish, after which the writeback can
+    -- start in the 'idle' state above.
+    -- This only stalls bursts that have not yet started, so it is safe in an AXI sense.
+    hold_data_bursts <= (
+      regs_down.writeback_config.enable
+      and writeback_pending
+      and to_sl(num_bursts_while_pending = max_bursts_while_pending)
+    );
+
+    writeback_b_valid <= (
+      axi_write_s2m.b.valid
+      and to_sl(state /= idle)
+      and to_sl(axi_write_s2m.b.id = writeback_axi_id)
+    );
+
+    writeback_m2s.aw.id <= to_unsigned(writeback_axi_id, writeback_m2s.aw.id'length);
+    writeback_m2s.aw.len <= to_len(burst_length_beats=>writeback_num_beats);
+    writeback_m2s.aw.size <= to_size(data_width_bits=>axi_data_width);
+    writeback_m2s.aw.burst <= axi_a_burst_incr;
+
+    writeback_m2s.w.id <= to_unsigned(writeback_axi_id, writeback_m2s.w.id'length);
+    writeback_m2s.w.last <= to_sl(writeback_beat_index = writeback_num_beats - 1);
+
+    -- If the AXI data width is wider than the value, only the bytes of the value are strobed.
+    writeback_m2s.w.data(writeback_beat_width - 1 downto 0) <= (
+      writeback_word(writeback_beat_width - 1 downto 0)
+    );
+    writeback_m2s.w.strb(writeback_beat_width / 8 - 1 downto 0) <= (others => '1');
+
+
+    ------------------------------------------------------------------------------
+    assign_bus : process(all)
+    begin
+      axi_write_m2s <= data_m2s;
+      data_s2m <= axi_write_s2m;
+
+      -- Only the data responses shall be seen by the ring buffer logic.
+      data_s2m.b.valid <= axi_write_s2m.b.valid and not writeback_b_valid;
+
+      if state = write then
+        axi_write_m2s.aw <= writeback_m2s.aw;
+        axi_write_m2s.w <= writeback_m2s.w;
+
+        data_s2m.aw.ready <= '0';
+        data_s2m.w.ready <= '0';
+      end if;
+    end process;
+
+
+  ------------------------------------------------------------------------------
+  else generate
+
+    num_packets_done <= (0 => write_done, others => '0');
+
+    axi_write_m2s <= data_m2s;
+    data_s2m <= axi_write_s2m;
+
+  end generate;
+
 end architecture;
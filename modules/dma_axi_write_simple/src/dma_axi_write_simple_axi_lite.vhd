@@ -10,6 +10,8 @@
 -- This top level is suitable for instantiation in a user design.
 -- It integrates :ref:`dma_axi_write_simple.dma_axi_write_simple` and an AXI-Lite
 -- register file.
+-- The registers of an optional feature are only present in the register file if the feature
+-- is enabled.
 --
 -- See :ref:`dma_axi_write_simple.dma_axi_write_simple` for more documentation.
 -- -------------------------------------------------------------------------------------------------
@@ -33,7 +35,17 @@ entity dma_axi_write_simple_axi_lite is
     stream_data_width : axi_data_width_t;
     axi_data_width : axi_data_width_t;
     packet_length_beats : positive;
-    enable_axi3 : boolean := false
+    enable_axi3 : boolean := false;
+    enable_telemetry : boolean := false;
+    enable_flush_timeout : boolean := false;
+    enable_interrupt_coalescing : boolean := false;
+    enable_address_pipelining : boolean := false;
+    max_outstanding_bursts : natural := 0;
+    axi_id : natural := 0;
+    enable_written_address_writeback : boolean := false;
+    writeback_axi_id : natural := 1;
+    enable_packet_metadata : boolean := false;
+    packet_metadata_fifo_depth : positive := 64
   );
   port (
     clk : in std_ulogic;
@@ -65,7 +77,17 @@ begin
       stream_data_width => stream_data_width,
       axi_data_width => axi_data_width,
       packet_length_beats => packet_length_beats,
-      enable_axi3 => enable_axi3
+      enable_axi3 => enable_axi3,
+      enable_telemetry => enable_telemetry,
+      enable_flush_timeout => enable_flush_timeout,
+      enable_interrupt_coalescing => enable_interrupt_coalescing,
+      enable_address_pipelining => enable_address_pipelining,
+      max_outstanding_bursts => max_outstanding_bursts,
+      axi_id => axi_id,
+      enable_written_address_writeback => enable_written_address_writeback,
+      writeback_axi_id => writeback_axi_id,
+      enable_packet_metadata => enable_packet_metadata,
+      packet_metadata_fifo_depth => packet_metadata_fifo_depth
     )
     port map (
       clk => clk,
@@ -84,8 +106,15 @@ begin
 
 
   ------------------------------------------------------------------------------
-  dma_axi_write_simple_register_file_axi_lite_inst :
-    entity work.dma_axi_write_simple_register_file_axi_lite
+  dma_axi_write_simple_register_file_inst : entity work.dma_axi_write_simple_register_file
+    generic map (
+      address_width => address_width,
+      enable_telemetry => enable_telemetry,
+      enable_flush_timeout => enable_flush_timeout,
+      enable_interrupt_coalescing => enable_interrupt_coalescing,
+      enable_written_address_writeback => enable_written_address_writeback,
+      enable_packet_metadata => enable_packet_metadata
+    )
     port map (
       clk => clk,
       --
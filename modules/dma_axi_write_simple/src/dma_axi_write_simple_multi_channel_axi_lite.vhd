@@ -0,0 +1,303 @@
+-- -------------------------------------------------------------------------------------------------
+-- Copyright (c) Lukas Vik. All rights reserved.
+--
+-- This file is part of the hdl-modules project, a collection of reusable, high-quality,
+-- peer-reviewed VHDL building blocks.
+-- https://hdl-modules.com
+-- https://github.com/hdl-modules/hdl-modules
+-- -------------------------------------------------------------------------------------------------
+-- Top level for the simple DMA module with multiple channels, with an **AXI-Lite**
+-- register interface.
+-- This top level is suitable for instantiation in a user design.
+--
+-- Each channel is an instance of :ref:`dma_axi_write_simple.dma_axi_write_simple`, with its own
+-- ``stream`` interface, its own memory buffer and its own register bank.
+-- The AXI ports of the channels are arbitrated onto one AXI master using
+-- :ref:`axi.axi_simple_write_crossbar`.
+-- This saves interconnect resources compared to instantiating
+-- :ref:`dma_axi_write_simple.dma_axi_write_simple_axi_lite` once for each channel.
+--
+-- See :ref:`dma_axi_write_simple.dma_axi_write_simple` for more documentation.
+--
+--
+-- Register layout
+-- _______________
+--
+-- The register bus is split using :ref:`axi_lite.axi_lite_mux`.
+-- At offset ``0x0`` there is a summary register bank:
+--
+-- * Register ``summary_channel_interrupts_index`` (``0``): One bit per channel, that is ``'1'``
+--   if the ``interrupt`` of that channel is asserted.
+-- * Register ``summary_first_written_address_index + N`` (``1 + N``): The
+--   ``buffer_written_address`` register value of channel ``N``.
+--
+-- Meaning that the software can find out the state of all channels by reading one
+-- contiguous block of registers, instead of polling each channel separately.
+-- Note that only the lower 32 bits of the written address are available here.
+--
+-- The register bank of channel ``N`` is at offset ``(1 + N) * channel_register_stride_bytes``
+-- (``0x100``), and has the same layout as :ref:`dma_axi_write_simple.register_interface`.
+-- The offsets and indexes are register constants in :ref:`dma_axi_write_simple.register_interface`,
+-- so they are available to software in the generated code.
+--
+-- The ``interrupt`` output of this entity is the OR of the interrupts of all channels.
+--
+--
+-- AXI throughput
+-- ______________
+--
+-- Since :ref:`axi.axi_simple_write_crossbar` waits for the ``B`` response of a burst before it
+-- starts the next one, the total throughput is lower than for separate AXI ports.
+-- A long packet length is recommended, so that this overhead is small in relation to the
+-- burst length.
+--
+-- Also, if the ``stream`` of one channel stops in the middle of a packet, all other channels will
+-- be blocked until it continues.
+-- See :ref:`dma_axi_write_simple.dma_axi_write_simple` for a discussion about this.
+-- -------------------------------------------------------------------------------------------------
+
+library ieee;
+use ieee.std_logic_1164.all;
+
+library axi;
+use axi.axi_pkg.all;
+
+library axi_lite;
+use axi_lite.axi_lite_pkg.all;
+
+library common;
+use common.addr_pkg.all;
+use common.types_pkg.all;
+
+library register_file;
+use register_file.register_file_pkg.all;
+
+use work.dma_axi_write_simple_register_record_pkg.all;
+use work.dma_axi_write_simple_regs_pkg.all;
+
+
+entity dma_axi_write_simple_multi_channel_axi_lite is
+  generic (
+    -- The number of channels, each with its own 'stream' and memory buffer.
+    num_channels : positive range 1 to register_width;
+    -- See 'dma_axi_write_simple.vhd' for documentation of the generics.
+    -- Apply to all channels.
+    address_width : axi_address_width_t;
+    stream_data_width : axi_data_width_t;
+    axi_data_width : axi_data_width_t;
+    packet_length_beats : positive;
+    enable_axi3 : boolean := false;
+    enable_telemetry : boolean := false;
+    enable_flush_timeout : boolean := false;
+    enable_interrupt_coalescing : boolean := false;
+    enable_address_pipelining : boolean := false;
+    enable_packet_metadata : boolean := false;
+    packet_metadata_fifo_depth : positive := 64
+  );
+  port (
+    clk : in std_ulogic;
+    --# {{}}
+    stream_ready : out std_ulogic_vector(0 to num_channels - 1) := (others => '0');
+    stream_valid : in std_ulogic_vector(0 to num_channels - 1);
+    stream_data : in slv_vec_t(0 to num_channels - 1)(stream_data_width - 1 downto 0);
+    --# {{}}
+    regs_m2s : in axi_lite_m2s_t;
+    regs_s2m : out axi_lite_s2m_t := axi_lite_s2m_init;
+    interrupt : out std_ulogic := '0';
+    --# {{}}
+    axi_write_m2s : out axi_write_m2s_t := axi_write_m2s_init;
+    axi_write_s2m : in axi_write_s2m_t
+  );
+end entity;
+
+architecture a of dma_axi_write_simple_multi_channel_axi_lite is
+
+  -- Register constants, that are available also to software through the generated code.
+  constant channel_register_stride_bytes : positive :=
+    dma_axi_write_simple_constant_channel_register_stride_bytes;
+  constant channel_interrupts_index : natural :=
+    dma_axi_write_simple_constant_summary_channel_interrupts_index;
+  constant first_written_address_index : natural :=
+    dma_axi_write_simple_constant_summary_first_written_address_index;
+
+  -- Summary bank at index zero, and then one bank per channel.
+  function get_base_addresses return addr_vec_t is
+    variable result : addr_vec_t(0 to num_channels) := (others => (others => '0'));
+  begin
+    for bank_idx in result'range loop
+      result(bank_idx) := to_addr(bank_idx * channel_register_stride_bytes);
+    end loop;
+
+    return result;
+  end function;
+  constant base_addresses : addr_vec_t(0 to num_channels) := get_base_addresses;
+
+  function get_summary_registers return register_definition_vec_t is
+    variable result : register_definition_vec_t(0 to num_channels);
+  begin
+    result(channel_interrupts_index) := (
+      index=>channel_interrupts_index, mode=>r, utilized_width=>num_channels
+    );
+
+    for channel_idx in 0 to num_channels - 1 loop
+      result(first_written_address_index + channel_idx) := (
+        index=>first_written_address_index + channel_idx,
+        mode=>r,
+        utilized_width=>minimum(address_width, register_width)
+      );
+    end loop;
+
+    return result;
+  end function;
+  constant summary_registers : register_definition_vec_t(0 to num_channels) :=
+    get_summary_registers;
+
+  signal summary_regs_up : register_vec_t(summary_registers'range) := (others => (others => '0'));
+
+  signal regs_m2s_vec : axi_lite_m2s_vec_t(base_addresses'range) := (
+    others => axi_lite_m2s_init
+  );
+  signal regs_s2m_vec : axi_lite_s2m_vec_t(base_addresses'range) := (
+    others => axi_lite_s2m_init
+  );
+
+  signal channel_interrupt : std_ulogic_vector(0 to num_channels - 1) := (others => '0');
+
+  signal axi_write_m2s_vec : axi_write_m2s_vec_t(0 to num_channels - 1) := (
+    others => axi_write_m2s_init
+  );
+  signal axi_write_s2m_vec : axi_write_s2m_vec_t(0 to num_channels - 1) := (
+    others => axi_write_s2m_init
+  );
+
+begin
+
+  ------------------------------------------------------------------------------
+  assert dma_axi_write_simple_register_map'length * 4 <= channel_register_stride_bytes
+    report "Register bank of one channel does not fit within the stride."
+    severity failure;
+
+  assert summary_registers'length * 4 <= channel_register_stride_bytes
+    report "Summary register bank does not fit within the stride."
+    severity failure;
+
+
+  ------------------------------------------------------------------------------
+  axi_lite_mux_inst : entity axi_lite.axi_lite_mux
+    generic map (
+      base_addresses => base_addresses
+    )
+    port map (
+      clk => clk,
+      --
+      axi_lite_m2s => regs_m2s,
+      axi_lite_s2m => regs_s2m,
+      --
+      axi_lite_m2s_vec => regs_m2s_vec,
+      axi_lite_s2m_vec => regs_s2m_vec
+    );
+
+
+  ------------------------------------------------------------------------------
+  summary_register_file_inst : entity register_file.axi_lite_register_file
+    generic map (
+      registers => summary_registers
+    )
+    port map (
+      clk => clk,
+      --
+      axi_lite_m2s => regs_m2s_vec(0),
+      axi_lite_s2m => regs_s2m_vec(0),
+      --
+      regs_up => summary_regs_up
+    );
+
+
+  ------------------------------------------------------------------------------
+  channel_gen : for channel_idx in 0 to num_channels - 1 generate
+    signal regs_up : dma_axi_write_simple_regs_up_t := dma_axi_write_simple_regs_up_init;
+    signal regs_down : dma_axi_write_simple_regs_down_t := dma_axi_write_simple_regs_down_init;
+  begin
+
+    ------------------------------------------------------------------------------
+    dma_axi_write_simple_core_inst : entity work.dma_axi_write_simple
+      generic map (
+        address_width => address_width,
+        stream_data_width => stream_data_width,
+        axi_data_width => axi_data_width,
+        packet_length_beats => packet_length_beats,
+        enable_axi3 => enable_axi3,
+        enable_telemetry => enable_telemetry,
+        enable_flush_timeout => enable_flush_timeout,
+        enable_interrupt_coalescing => enable_interrupt_coalescing,
+        enable_address_pipelining => enable_address_pipelining,
+        -- The crossbar does not let more than one burst be outstanding anyway.
+        max_outstanding_bursts => 0,
+        axi_id => 0,
+        -- Software reads the written addresses from the summary register bank instead.
+        enable_written_address_writeback => false,
+        writeback_axi_id => 0,
+        enable_packet_metadata => enable_packet_metadata,
+        packet_metadata_fifo_depth => packet_metadata_fifo_depth
+      )
+      port map (
+        clk => clk,
+        --
+        stream_ready => stream_ready(channel_idx),
+        stream_valid => stream_valid(channel_idx),
+        stream_data => stream_data(channel_idx),
+        --
+        regs_up => regs_up,
+        regs_down => regs_down,
+        interrupt => channel_interrupt(channel_idx),
+        --
+        axi_write_m2s => axi_write_m2s_vec(channel_idx),
+        axi_write_s2m => axi_write_s2m_vec(channel_idx)
+      );
+
+
+    ------------------------------------------------------------------------------
+    dma_axi_write_simple_register_file_inst : entity work.dma_axi_write_simple_register_file
+      generic map (
+        address_width => address_width,
+        enable_telemetry => enable_telemetry,
+        enable_flush_timeout => enable_flush_timeout,
+        enable_interrupt_coalescing => enable_interrupt_coalescing,
+        enable_written_address_writeback => false,
+        enable_packet_metadata => enable_packet_metadata
+      )
+      port map (
+        clk => clk,
+        --
+        axi_lite_m2s => regs_m2s_vec(1 + channel_idx),
+        axi_lite_s2m => regs_s2m_vec(1 + channel_idx),
+        --
+        regs_up => regs_up,
+        regs_down => regs_down
+      );
+
+    summary_regs_up(channel_interrupts_index)(channel_idx) <= channel_interrupt(channel_idx);
+    summary_regs_up(first_written_address_index + channel_idx) <=
+      regs_up.buffer_written_address;
+
+  end generate;
+
+  interrupt <= or channel_interrupt;
+
+
+  ------------------------------------------------------------------------------
+  axi_simple_write_crossbar_inst : entity axi.axi_simple_write_crossbar
+    generic map (
+      num_inputs => num_channels
+    )
+    port map (
+      clk => clk,
+      --
+      input_ports_m2s => axi_write_m2s_vec,
+      input_ports_s2m => axi_write_s2m_vec,
+      --
+      output_m2s => axi_write_m2s,
+      output_s2m => axi_write_s2m
+    );
+
+end architecture;
@@ -0,0 +1,153 @@
+-- -------------------------------------------------------------------------------------------------
+-- Copyright (c) Lukas Vik. All rights reserved.
+--
+-- This file is part of the hdl-modules project, a collection of reusable, high-quality,
+-- peer-reviewed VHDL building blocks.
+-- https://hdl-modules.com
+-- https://github.com/hdl-modules/hdl-modules
+-- -------------------------------------------------------------------------------------------------
+-- AXI-Lite register file for :ref:`dma_axi_write_simple.dma_axi_write_simple`, where
+-- the registers of optional features are only included if the corresponding generic is set.
+-- So that an optional feature costs no resources at all in the register file when it is
+-- not enabled.
+--
+-- The same goes for the ``_high`` address registers, which are only included if the
+-- ``address_width`` generic is greater than 32.
+--
+-- The registers of the optional features are placed last in the register map, grouped
+-- by feature.
+-- The register file ends after the last register of the last enabled feature.
+-- Registers of disabled features within that range have no utilized bits, meaning they read as
+-- zero and ignore writes.
+-- Registers of disabled features after that range are not part of the register file, and an
+-- access to them will give a ``SLVERR`` response.
+-- With all optional features disabled and an ``address_width`` of 32 or less, the register file
+-- holds only the seven registers up to and including ``buffer_read_address``.
+-- -------------------------------------------------------------------------------------------------
+
+library ieee;
+use ieee.std_logic_1164.all;
+
+library axi_lite;
+use axi_lite.axi_lite_pkg.all;
+
+library register_file;
+use register_file.register_file_pkg.all;
+
+use work.dma_axi_write_simple_register_record_pkg.all;
+use work.dma_axi_write_simple_regs_pkg.all;
+
+
+entity dma_axi_write_simple_register_file is
+  generic (
+    -- See 'dma_axi_write_simple.vhd' for documentation of the generics.
+    address_width : positive;
+    enable_telemetry : boolean;
+    enable_flush_timeout : boolean;
+    enable_interrupt_coalescing : boolean;
+    enable_written_address_writeback : boolean;
+    enable_packet_metadata : boolean
+  );
+  port (
+    clk : in std_ulogic;
+    --# {{}}
+    axi_lite_m2s : in axi_lite_m2s_t;
+    axi_lite_s2m : out axi_lite_s2m_t := axi_lite_s2m_init;
+    --# {{}}
+    regs_up : in dma_axi_write_simple_regs_up_t;
+    regs_down : out dma_axi_write_simple_regs_down_t := dma_axi_write_simple_regs_down_init
+  );
+end entity;
+
+architecture a of dma_axi_write_simple_register_file is
+
+  constant enable_address_high : boolean := address_width > register_width;
+
+  function is_register_enabled(index : natural) return boolean is
+  begin
+    if index <= dma_axi_write_simple_buffer_read_address then
+      return true;
+    end if;
+
+    if index <= dma_axi_write_simple_buffer_read_address_high then
+      return enable_address_high;
+    end if;
+
+    if index <= dma_axi_write_simple_telemetry_control then
+      return enable_telemetry;
+    end if;
+
+    if index <= dma_axi_write_simple_flush_timeout_cycles then
+      return enable_flush_timeout;
+    end if;
+
+    if index <= dma_axi_write_simple_interrupt_coalescing_timeout_cycles then
+      return enable_interrupt_coalescing;
+    end if;
+
+    if index = dma_axi_write_simple_writeback_address_high then
+      return enable_written_address_writeback and enable_address_high;
+    end if;
+
+    if index <= dma_axi_write_simple_writeback_config then
+      return enable_written_address_writeback;
+    end if;
+
+    return enable_packet_metadata;
+  end function;
+
+  function get_last_register_index return natural is
+  begin
+    for index in dma_axi_write_simple_register_map'high downto 0 loop
+      if is_register_enabled(index) then
+        return index;
+      end if;
+    end loop;
+
+    return 0;
+  end function;
+  constant last_register_index : natural := get_last_register_index;
+
+  function get_register_map return register_definition_vec_t is
+    variable result : register_definition_vec_t(0 to last_register_index) := (
+      dma_axi_write_simple_register_map(0 to last_register_index)
+    );
+  begin
+    for index in result'range loop
+      if not is_register_enabled(index) then
+        result(index).utilized_width := 0;
+      end if;
+    end loop;
+
+    return result;
+  end function;
+  constant register_map : register_definition_vec_t(0 to last_register_index) := get_register_map;
+
+  signal regs_up_slv, regs_down_slv : dma_axi_write_simple_regs_t := (
+    dma_axi_write_simple_regs_init
+  );
+
+begin
+
+  regs_up_slv <= to_slv(regs_up);
+  -- Registers that are not in the register file keep their default value.
+  regs_down <= to_dma_axi_write_simple_regs_down(regs_down_slv);
+
+
+  ------------------------------------------------------------------------------
+  axi_lite_register_file_inst : entity register_file.axi_lite_register_file
+    generic map (
+      registers => register_map,
+      default_values => dma_axi_write_simple_regs_init(register_map'range)
+    )
+    port map (
+      clk => clk,
+      --
+      axi_lite_m2s => axi_lite_m2s,
+      axi_lite_s2m => axi_lite_s2m,
+      --
+      regs_up => regs_up_slv(register_map'range),
+      regs_down => regs_down_slv(register_map'range)
+    );
+
+end architecture;
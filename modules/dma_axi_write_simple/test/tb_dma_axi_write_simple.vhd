@@ -16,6 +16,7 @@ use osvvm.RandomPkg.RandomPType;
 
 library vunit_lib;
 use vunit_lib.axi_slave_pkg.all;
+use vunit_lib.check_pkg.all;
 use vunit_lib.com_pkg.net;
 use vunit_lib.integer_array_pkg.all;
 use vunit_lib.memory_pkg.all;
@@ -32,6 +33,8 @@ use axi_lite.axi_lite_pkg.all;
 library bfm;
 use bfm.stall_bfm_pkg.all;
 
+use work.dma_axi_write_simple_register_read_write_pkg.all;
+use work.dma_axi_write_simple_register_record_pkg.all;
 use work.dma_axi_write_simple_sim_pkg.all;
 
 
@@ -99,6 +102,13 @@ architecture tb of tb_dma_axi_write_simple is
   constant packet_length_bytes : positive := packet_length_axi_beats * axi_bytes_per_beat;
   constant packet_length_beats : positive := packet_length_bytes / stream_bytes_per_beat;
 
+  constant max_burst_length_beats : positive := get_max_burst_length_beats(
+    enable_axi3=>enable_axi3
+  );
+  constant num_bursts_per_packet : positive := maximum(
+    1, packet_length_axi_beats / max_burst_length_beats
+  );
+
   -- ---------------------------------------------------------------------------
   -- DUT connections.
   constant clk_period : time := 10 ns;
@@ -112,6 +122,7 @@ architecture tb of tb_dma_axi_write_simple is
 
   signal regs_m2s : axi_lite_m2s_t := axi_lite_m2s_init;
   signal regs_s2m : axi_lite_s2m_t := axi_lite_s2m_init;
+  signal interrupt : std_ulogic := '0';
 
   -- ---------------------------------------------------------------------------
   -- Testbench stuff.
@@ -139,6 +150,69 @@ architecture tb of tb_dma_axi_write_simple is
   end function;
   constant w_fifo_depth : natural := get_w_fifo_depth;
 
+  impure function get_enable_telemetry return boolean is
+  begin
+    return rnd.RandBool;
+  end function;
+  constant enable_telemetry : boolean := get_enable_telemetry;
+
+  impure function get_enable_flush_timeout return boolean is
+  begin
+    return rnd.RandBool;
+  end function;
+  constant enable_flush_timeout : boolean := get_enable_flush_timeout;
+
+  impure function get_enable_interrupt_coalescing return boolean is
+  begin
+    return rnd.RandBool;
+  end function;
+  constant enable_interrupt_coalescing : boolean := get_enable_interrupt_coalescing;
+
+  impure function get_enable_address_pipelining return boolean is
+  begin
+    return rnd.RandBool;
+  end function;
+  constant enable_address_pipelining : boolean := get_enable_address_pipelining;
+
+  impure function get_max_outstanding_bursts return natural is
+  begin
+    return rnd.Uniform(0, 3);
+  end function;
+  constant max_outstanding_bursts : natural := get_max_outstanding_bursts;
+
+  constant id_width : positive := 4;
+  impure function get_axi_id return natural is
+  begin
+    return rnd.Uniform(0, 2 ** id_width - 1);
+  end function;
+  constant axi_id : natural := get_axi_id;
+
+  impure function get_enable_written_address_writeback return boolean is
+  begin
+    return rnd.RandBool;
+  end function;
+  constant enable_written_address_writeback : boolean := get_enable_written_address_writeback;
+  constant writeback_axi_id : natural := (axi_id + 1) mod 2 ** id_width;
+  -- Eight bytes are written, but for wide AXI buses the address must be aligned to the data width.
+  constant writeback_num_bytes : positive := maximum(8, axi_bytes_per_beat);
+
+  impure function get_enable_packet_metadata return boolean is
+  begin
+    return rnd.RandBool;
+  end function;
+  constant enable_packet_metadata : boolean := get_enable_packet_metadata;
+
+  impure function get_packet_metadata_fifo_depth return positive is
+  begin
+    -- Sometimes smaller than the number of packets in the test, so that entries are dropped.
+    return 2 ** rnd.Uniform(2, 4);
+  end function;
+  constant packet_metadata_fifo_depth : positive := get_packet_metadata_fifo_depth;
+
+  -- Must be longer than the stall of the stream BFM, so that the flush happens only at the end of
+  -- the test data.
+  constant flush_timeout_cycles : positive := 20;
+
   constant stream_data_queue : queue_t := new_queue;
 
 begin
@@ -155,20 +229,73 @@ begin
     -- Make it roll around a few times.
     constant test_data_num_bytes : positive := 3 * buffer_size_bytes;
 
+    -- When testing the flush, end the stream data in the middle of a packet.
+    -- The rest of the packet shall be padded with zeros by the DUT.
+    impure function get_num_padding_bytes return natural is
+    begin
+      if enable_flush_timeout then
+        return rnd.Uniform(0, packet_length_beats - 1) * stream_bytes_per_beat;
+      end if;
+
+      return 0;
+    end function;
+    constant num_padding_bytes : natural := get_num_padding_bytes;
+    constant stream_data_num_bytes : positive := test_data_num_bytes - num_padding_bytes;
+
+    variable writeback_buf : buffer_t := null_buffer;
+
+    procedure setup_writeback is
+    begin
+      writeback_buf := allocate(
+        memory => memory,
+        num_bytes => writeback_num_bytes,
+        name=>"dma_axi_write_simple_writeback",
+        alignment=>writeback_num_bytes,
+        permissions=>write_only
+      );
+
+      write_dma_axi_write_simple_writeback_address(net=>net, value=>base_address(writeback_buf));
+      write_dma_axi_write_simple_writeback_config(net=>net, value=>(enable=>'1'));
+    end procedure;
+
     procedure run_test is
-      variable data, data_copy : integer_array_t := null_integer_array;
+      variable input_data, data : integer_array_t := null_integer_array;
     begin
       report "buffer_size_packets = " & to_string(buffer_size_packets);
+      report "num_padding_bytes = " & to_string(num_padding_bytes);
 
       random_integer_array(
         rnd => rnd,
-        integer_array => data,
-        width => test_data_num_bytes,
+        integer_array => input_data,
+        width => stream_data_num_bytes,
         bits_per_word => 8,
         is_signed => false
       );
-      data_copy := copy(data);
-      push_ref(stream_data_queue, data_copy);
+
+      data := new_1d(length=>test_data_num_bytes, bit_width=>8, is_signed=>false);
+      for byte_idx in 0 to stream_data_num_bytes - 1 loop
+        set(arr=>data, idx=>byte_idx, value=>get(arr=>input_data, idx=>byte_idx));
+      end loop;
+      -- Note that 'new_1d' initializes all values to zero, which is the expected padding.
+
+      push_ref(stream_data_queue, input_data);
+
+      if enable_flush_timeout then
+        write_dma_axi_write_simple_flush_timeout_cycles(net=>net, value=>flush_timeout_cycles);
+      end if;
+
+      if enable_written_address_writeback then
+        setup_writeback;
+      end if;
+
+      if enable_interrupt_coalescing then
+        write_dma_axi_write_simple_interrupt_coalescing_packets(
+          net=>net, value=>rnd.Uniform(0, 2 * buffer_size_packets)
+        );
+        write_dma_axi_write_simple_interrupt_coalescing_timeout_cycles(
+          net=>net, value=>rnd.Uniform(1, 200)
+        );
+      end if;
 
       run_dma_axi_write_simple_test(
         rnd => rnd,
@@ -179,6 +306,344 @@ begin
         memory => memory
       );
     end procedure;
+
+    procedure setup_buffer(buf : out buffer_t; num_bytes : positive) is
+    begin
+      buf := allocate(
+        memory => memory,
+        num_bytes => num_bytes,
+        name=>"dma_axi_write_simple_test_buffer",
+        alignment=>packet_length_bytes,
+        permissions=>write_only
+      );
+
+      write_dma_axi_write_simple_buffer_start_address(net=>net, value=>base_address(buf));
+      write_dma_axi_write_simple_buffer_end_address(net=>net, value=>last_address(buf) + 1);
+      write_dma_axi_write_simple_buffer_read_address(net=>net, value=>base_address(buf));
+    end procedure;
+
+    -- Check the data in the buffer from 'read_address' up to 'written_address', and then release
+    -- the buffer space to the DUT.
+    procedure receive_data(
+      buf : buffer_t;
+      written_address : natural;
+      read_address : inout natural;
+      expected_data : integer_array_t;
+      num_bytes_received : inout natural
+    ) is
+    begin
+      while read_address /= written_address loop
+        check_equal(
+          read_byte(memory=>memory, address=>read_address),
+          get(arr=>expected_data, idx=>num_bytes_received),
+          "num_bytes_received: " & to_string(num_bytes_received)
+        );
+        num_bytes_received := num_bytes_received + 1;
+
+        if read_address = last_address(buf) then
+          read_address := base_address(buf);
+        else
+          read_address := read_address + 1;
+        end if;
+      end loop;
+
+      write_dma_axi_write_simple_buffer_read_address(net=>net, value=>read_address);
+    end procedure;
+
+    -- Work like the software driver does in writeback mode: Wait for the interrupt, clear it, and
+    -- then read the written address from the writeback location in memory.
+    -- If the interrupt would trigger before the writeback value is in memory, the software would
+    -- read a stale value and then wait forever for the last packet.
+    -- Which would make the interrupt wait below time out.
+    procedure run_interrupt_writeback_test is
+      variable input_data, stream_input_data : integer_array_t := null_integer_array;
+      variable buf : buffer_t := null_buffer;
+      variable interrupt_clear : dma_axi_write_simple_interrupt_status_t := (
+        dma_axi_write_simple_interrupt_status_init
+      );
+      variable written_address, read_address, num_bytes_received : natural := 0;
+    begin
+      random_integer_array(
+        rnd => rnd,
+        integer_array => input_data,
+        width => test_data_num_bytes,
+        bits_per_word => 8,
+        is_signed => false
+      );
+      stream_input_data := copy(input_data);
+      push_ref(stream_data_queue, stream_input_data);
+
+      setup_buffer(buf=>buf, num_bytes=>buffer_size_bytes);
+      read_address := base_address(buf);
+
+      setup_writeback;
+
+      write_dma_axi_write_simple_interrupt_mask(net=>net, value=>(write_done=>'1', others=>'0'));
+      write_dma_axi_write_simple_config(net=>net, value=>(enable=>'1'));
+
+      interrupt_clear.write_done := '1';
+
+      while num_bytes_received /= test_data_num_bytes loop
+        if interrupt /= '1' then
+          wait until interrupt = '1' for 1000 * packet_length_beats * clk_period;
+        end if;
+        check_equal(interrupt, '1', "Timeout waiting for write_done interrupt");
+
+        write_dma_axi_write_simple_interrupt_status(net=>net, value=>interrupt_clear);
+
+        written_address := to_integer(
+          unsigned(
+            read_word(memory=>memory, address=>base_address(writeback_buf), bytes_per_word=>4)
+          )
+        );
+
+        -- Note that there might be no new data, if the interrupt was triggered by a writeback
+        -- whose value we had already seen in the previous round.
+        receive_data(
+          buf=>buf,
+          written_address=>written_address,
+          read_address=>read_address,
+          expected_data=>input_data,
+          num_bytes_received=>num_bytes_received
+        );
+      end loop;
+    end procedure;
+
+    -- Send the packets in groups of 'interrupt_coalescing_packets', and receive each group once
+    -- the interrupt has triggered.
+    -- Meaning that every pulse of the coalesced interrupt is seen separately, so that the number of
+    -- pulses can be checked exactly.
+    -- The last group is a single packet, so the packet limit is never reached and the interrupt
+    -- must be triggered by the timeout.
+    procedure run_interrupt_coalescing_test is
+      constant num_packets_limit : positive := rnd.Uniform(2, 4);
+      constant num_full_groups : positive := rnd.Uniform(1, 3);
+      constant num_packets : positive := num_full_groups * num_packets_limit + 1;
+      constant timeout_cycles : positive := rnd.Uniform(20, 200);
+
+      -- The DUT never fills the last packet of the buffer, so this fits one group.
+      constant group_buffer_size_bytes : positive := (num_packets_limit + 1) * packet_length_bytes;
+      -- Generous, since the AXI slave stalls a lot.
+      constant group_max_cycles : positive := (
+        100 * num_packets_limit * packet_length_axi_beats + 1000
+      );
+
+      variable group_data, stream_input_data : integer_array_t := null_integer_array;
+      variable buf : buffer_t := null_buffer;
+      variable interrupt_clear : dma_axi_write_simple_interrupt_status_t := (
+        dma_axi_write_simple_interrupt_status_init
+      );
+      variable written_address, read_address, num_bytes_received : natural := 0;
+      variable num_group_packets, num_interrupts, num_responses : natural := 0;
+      variable first_packet_done_time : time := 0 ns;
+    begin
+      report "num_packets_limit = " & to_string(num_packets_limit);
+      report "num_packets = " & to_string(num_packets);
+      report "timeout_cycles = " & to_string(timeout_cycles);
+
+      setup_buffer(buf=>buf, num_bytes=>group_buffer_size_bytes);
+      read_address := base_address(buf);
+
+      write_dma_axi_write_simple_interrupt_coalescing_packets(net=>net, value=>num_packets_limit);
+      -- No timeout to begin with, so that only the packet limit triggers the interrupt.
+      write_dma_axi_write_simple_interrupt_coalescing_timeout_cycles(net=>net, value=>0);
+
+      write_dma_axi_write_simple_interrupt_mask(net=>net, value=>(write_done=>'1', others=>'0'));
+      write_dma_axi_write_simple_config(net=>net, value=>(enable=>'1'));
+
+      interrupt_clear.write_done := '1';
+
+      for group_idx in 0 to num_full_groups loop
+        if group_idx < num_full_groups then
+          num_group_packets := num_packets_limit;
+        else
+          num_group_packets := 1;
+          write_dma_axi_write_simple_interrupt_coalescing_timeout_cycles(
+            net=>net, value=>timeout_cycles
+          );
+        end if;
+
+        random_integer_array(
+          rnd => rnd,
+          integer_array => group_data,
+          width => num_group_packets * packet_length_bytes,
+          bits_per_word => 8,
+          is_signed => false
+        );
+        stream_input_data := copy(group_data);
+        push_ref(stream_data_queue, stream_input_data);
+
+        if group_idx < num_full_groups then
+          wait until interrupt = '1' for group_max_cycles * clk_period;
+        else
+          -- Wait for the 'B' responses of the single packet.
+          num_responses := 0;
+          while num_responses < num_bursts_per_packet loop
+            wait until rising_edge(clk);
+
+            if axi_s2m.b.valid = '1' and axi_s2m.b.id = axi_id then
+              num_responses := num_responses + 1;
+            end if;
+          end loop;
+          first_packet_done_time := now;
+
+          -- Allow for the latency of the interrupt register, and of the packet counting when the
+          -- writeback is present but not enabled.
+          wait until interrupt = '1' for (timeout_cycles + 8) * clk_period;
+          check_relation(
+            now - first_packet_done_time >= timeout_cycles * clk_period,
+            "Interrupt before the timeout"
+          );
+        end if;
+        check_equal(interrupt, '1', "Timeout waiting for write_done interrupt");
+        num_interrupts := num_interrupts + 1;
+
+        write_dma_axi_write_simple_interrupt_status(net=>net, value=>interrupt_clear);
+
+        -- All packets of the group must be in memory when the interrupt triggers.
+        read_dma_axi_write_simple_buffer_written_address(net=>net, value=>written_address);
+        num_bytes_received := 0;
+        receive_data(
+          buf=>buf,
+          written_address=>written_address,
+          read_address=>read_address,
+          expected_data=>group_data,
+          num_bytes_received=>num_bytes_received
+        );
+        check_equal(num_bytes_received, length(group_data), "group_idx: " & to_string(group_idx));
+
+        -- There shall be no further interrupt for the packets of this group.
+        wait for (timeout_cycles + 8) * clk_period;
+        check_equal(interrupt, '0', "Unexpected interrupt after group " & to_string(group_idx));
+      end loop;
+
+      check_equal(
+        num_interrupts,
+        (num_packets + num_packets_limit - 1) / num_packets_limit,
+        "Number of interrupt pulses"
+      );
+    end procedure;
+
+    -- With interrupt coalescing, the last packets are signaled only after a timeout.
+    -- But either way, the interrupt must eventually trigger.
+    procedure check_write_done_interrupt is
+      variable value : dma_axi_write_simple_interrupt_status_t := (
+        dma_axi_write_simple_interrupt_status_init
+      );
+    begin
+      wait for 200 * clk_period;
+
+      read_dma_axi_write_simple_interrupt_status(net=>net, value=>value);
+      check_equal(value.write_done, '1', "write_done");
+    end procedure;
+
+    -- The last writeback shall reflect the final state, after all packets have been written.
+    procedure check_writeback is
+      variable written_address : natural := 0;
+    begin
+      read_dma_axi_write_simple_buffer_written_address(net=>net, value=>written_address);
+
+      check_equal(
+        unsigned(
+          read_word(memory=>memory, address=>base_address(writeback_buf), bytes_per_word=>4)
+        ),
+        written_address,
+        "writeback buffer_written_address"
+      );
+      check_equal(
+        unsigned(
+          read_word(memory=>memory, address=>base_address(writeback_buf) + 4, bytes_per_word=>4)
+        ),
+        test_data_num_bytes / packet_length_bytes,
+        "writeback sequence number"
+      );
+    end procedure;
+
+    procedure check_telemetry is
+      variable value : natural := 0;
+    begin
+      read_dma_axi_write_simple_telemetry_packets_written(net=>net, value=>value);
+      check_equal(value, test_data_num_bytes / packet_length_bytes, "packets_written");
+
+      read_dma_axi_write_simple_telemetry_peak_fill(net=>net, value=>value);
+      -- The test consumes data slowly, so we should have seen data in the buffer.
+      -- The module never fills the very last packet of the buffer.
+      check_relation(value > 0);
+      check_relation(value <= buffer_size_bytes - packet_length_bytes);
+      check_equal(value mod packet_length_bytes, 0, "peak_fill");
+
+      -- The stall counters depend on the random stall behavior, and can not be checked exactly.
+      read_dma_axi_write_simple_telemetry_full_stall_cycles(net=>net, value=>value);
+      report "telemetry_full_stall_cycles = " & to_string(value);
+
+      read_dma_axi_write_simple_telemetry_axi_stall_cycles(net=>net, value=>value);
+      report "telemetry_axi_stall_cycles = " & to_string(value);
+
+      -- All stream data has been written, and the software has consumed all of it.
+      -- So everything should be zero after clearing.
+      write_dma_axi_write_simple_telemetry_control(net=>net, value=>(clear=>'1'));
+
+      read_dma_axi_write_simple_telemetry_full_stall_cycles(net=>net, value=>value);
+      check_equal(value, 0, "full_stall_cycles after clear");
+      read_dma_axi_write_simple_telemetry_axi_stall_cycles(net=>net, value=>value);
+      check_equal(value, 0, "axi_stall_cycles after clear");
+      read_dma_axi_write_simple_telemetry_packets_written(net=>net, value=>value);
+      check_equal(value, 0, "packets_written after clear");
+      read_dma_axi_write_simple_telemetry_peak_fill(net=>net, value=>value);
+      check_equal(value, 0, "peak_fill after clear");
+    end procedure;
+
+    -- The test does not pop any metadata while running, so the FIFO holds the entries of the first
+    -- packets, and the entries of the rest are dropped.
+    procedure check_packet_metadata is
+      constant num_packets : positive := test_data_num_bytes / packet_length_bytes;
+      constant num_entries : natural := minimum(num_packets, packet_metadata_fifo_depth);
+
+      variable status : dma_axi_write_simple_packet_metadata_status_t := (
+        dma_axi_write_simple_packet_metadata_status_init
+      );
+      variable sequence_number, timestamp, timestamp_high, previous_timestamp : natural := 0;
+      variable num_padding_beats, expected_num_padding_beats : natural := 0;
+    begin
+      read_dma_axi_write_simple_packet_metadata_status(net=>net, value=>status);
+      check_equal(status.level, num_entries, "packet_metadata_status.level");
+
+      for entry_idx in 0 to num_entries - 1 loop
+        read_dma_axi_write_simple_packet_metadata_sequence_number(
+          net=>net, value=>sequence_number
+        );
+        check_equal(sequence_number, entry_idx, "packet_metadata_sequence_number");
+
+        read_dma_axi_write_simple_packet_metadata_timestamp(net=>net, value=>timestamp);
+        read_dma_axi_write_simple_packet_metadata_timestamp_high(net=>net, value=>timestamp_high);
+        -- The simulation is nowhere near long enough to wrap the lower register.
+        check_equal(timestamp_high, 0, "packet_metadata_timestamp_high");
+
+        -- The stream accepts at most one beat per clock cycle.
+        if entry_idx > 0 then
+          check_relation(timestamp >= previous_timestamp + packet_length_beats);
+        end if;
+        previous_timestamp := timestamp;
+
+        -- Only the last packet is flushed, when the stream data ends.
+        expected_num_padding_beats := 0;
+        if entry_idx = num_packets - 1 then
+          expected_num_padding_beats := num_padding_bytes / stream_bytes_per_beat;
+        end if;
+
+        read_dma_axi_write_simple_packet_metadata_num_padding_beats(
+          net=>net, value=>num_padding_beats
+        );
+        check_equal(
+          num_padding_beats, expected_num_padding_beats, "packet_metadata_num_padding_beats"
+        );
+
+        write_dma_axi_write_simple_packet_metadata_control(net=>net, value=>(pop=>'1'));
+      end loop;
+
+      read_dma_axi_write_simple_packet_metadata_status(net=>net, value=>status);
+      check_equal(status.level, 0, "packet_metadata_status.level after pop");
+    end procedure;
   begin
     test_runner_setup(runner, runner_cfg);
 
@@ -188,9 +653,48 @@ begin
     report "packet_length_beats = " & to_string(packet_length_beats);
     report "enable_axi3 = " & to_string(enable_axi3);
     report "w_fifo_depth = " & to_string(w_fifo_depth);
+    report "enable_telemetry = " & to_string(enable_telemetry);
+    report "enable_flush_timeout = " & to_string(enable_flush_timeout);
+    report "enable_interrupt_coalescing = " & to_string(enable_interrupt_coalescing);
+    report "enable_address_pipelining = " & to_string(enable_address_pipelining);
+    report "max_outstanding_bursts = " & to_string(max_outstanding_bursts);
+    report "axi_id = " & to_string(axi_id);
+    report "enable_written_address_writeback = " & to_string(enable_written_address_writeback);
+    report "enable_packet_metadata = " & to_string(enable_packet_metadata);
+    report "packet_metadata_fifo_depth = " & to_string(packet_metadata_fifo_depth);
 
     if run("test_dma_axi_write_simple") then
       run_test;
+
+      -- The registers of disabled features are not present in the register file.
+      if enable_telemetry then
+        check_telemetry;
+      end if;
+
+      if enable_packet_metadata then
+        check_packet_metadata;
+      end if;
+
+      check_write_done_interrupt;
+
+      if enable_written_address_writeback then
+        check_writeback;
+      end if;
+
+    elsif run("test_write_done_interrupt_coalescing") then
+      if enable_interrupt_coalescing then
+        run_interrupt_coalescing_test;
+      else
+        report "Skipping, since interrupt coalescing is not enabled in this configuration.";
+      end if;
+
+    elsif run("test_write_done_interrupt_with_writeback") then
+      if enable_written_address_writeback then
+        run_interrupt_writeback_test;
+        check_writeback;
+      else
+        report "Skipping, since the writeback is not enabled in this configuration.";
+      end if;
     end if;
 
     check_expected_was_written(memory);
@@ -199,6 +703,83 @@ begin
   end process;
 
 
+  ------------------------------------------------------------------------------
+  check_axi : process
+    -- See the documentation of the written address writeback in the DUT.
+    impure function get_max_bursts_before_writeback return positive is
+    begin
+      if enable_address_pipelining then
+        return 4;
+      end if;
+
+      return 3;
+    end function;
+    constant max_bursts_before_writeback : positive := get_max_bursts_before_writeback;
+
+    variable num_outstanding_bursts, num_data_responses : natural := 0;
+    variable writeback_pending : boolean := false;
+    variable num_bursts_while_writeback_pending : natural := 0;
+  begin
+    wait until rising_edge(clk);
+
+    if axi_m2s.aw.valid then
+      check_relation(
+        axi_m2s.aw.id = axi_id
+        or (enable_written_address_writeback and axi_m2s.aw.id = writeback_axi_id),
+        "Unexpected AWID"
+      );
+    end if;
+
+    if enable_axi3 and axi_m2s.w.valid = '1' then
+      check_relation(
+        axi_m2s.w.id = axi_id
+        or (enable_written_address_writeback and axi_m2s.w.id = writeback_axi_id),
+        "Unexpected WID"
+      );
+    end if;
+
+    -- The limit applies only to the data bursts, not the writeback.
+    if axi_m2s.aw.valid = '1' and axi_s2m.aw.ready = '1' and axi_m2s.aw.id = axi_id then
+      num_outstanding_bursts := num_outstanding_bursts + 1;
+    end if;
+
+    if axi_m2s.b.ready = '1' and axi_s2m.b.valid = '1' and axi_s2m.b.id = axi_id then
+      num_outstanding_bursts := num_outstanding_bursts - 1;
+    end if;
+
+    if max_outstanding_bursts > 0 then
+      check_relation(
+        num_outstanding_bursts <= max_outstanding_bursts, "Too many outstanding bursts"
+      );
+    end if;
+
+    -- The writeback must not be starved by a continuous flow of data bursts.
+    if enable_written_address_writeback then
+      if axi_m2s.aw.valid = '1' and axi_s2m.aw.ready = '1' then
+        if axi_m2s.aw.id = writeback_axi_id then
+          writeback_pending := false;
+          num_bursts_while_writeback_pending := 0;
+
+        elsif writeback_pending then
+          num_bursts_while_writeback_pending := num_bursts_while_writeback_pending + 1;
+          check_relation(
+            num_bursts_while_writeback_pending <= max_bursts_before_writeback,
+            "Too many data bursts before writeback"
+          );
+        end if;
+      end if;
+
+      if axi_m2s.b.ready = '1' and axi_s2m.b.valid = '1' and axi_s2m.b.id = axi_id then
+        num_data_responses := num_data_responses + 1;
+
+        if num_data_responses mod num_bursts_per_packet = 0 then
+          writeback_pending := true;
+        end if;
+      end if;
+    end if;
+  end process;
+
+
   ------------------------------------------------------------------------------
   axi_stream_master_inst : entity bfm.axi_stream_master
     generic map (
@@ -232,7 +813,7 @@ begin
     generic map (
       axi_slave => axi_slave,
       data_width => axi_data_width,
-      id_width => 0,
+      id_width => id_width,
       w_fifo_depth => w_fifo_depth,
       enable_axi3 => enable_axi3
     )
@@ -251,7 +832,17 @@ begin
       stream_data_width => stream_data_width,
       axi_data_width => axi_data_width,
       packet_length_beats => packet_length_beats,
-      enable_axi3 => enable_axi3
+      enable_axi3 => enable_axi3,
+      enable_telemetry => enable_telemetry,
+      enable_flush_timeout => enable_flush_timeout,
+      enable_interrupt_coalescing => enable_interrupt_coalescing,
+      enable_address_pipelining => enable_address_pipelining,
+      max_outstanding_bursts => max_outstanding_bursts,
+      axi_id => axi_id,
+      enable_written_address_writeback => enable_written_address_writeback,
+      writeback_axi_id => writeback_axi_id,
+      enable_packet_metadata => enable_packet_metadata,
+      packet_metadata_fifo_depth => packet_metadata_fifo_depth
     )
     port map (
       clk => clk,
@@ -262,6 +853,7 @@ begin
       --
       regs_m2s => regs_m2s,
       regs_s2m => regs_s2m,
+      interrupt => interrupt,
       --
       axi_write_m2s => axi_m2s,
       axi_write_s2m => axi_s2m
@@ -0,0 +1,360 @@
+-- -------------------------------------------------------------------------------------------------
+-- Copyright (c) Lukas Vik. All rights reserved.
+--
+-- This file is part of the hdl-modules project, a collection of reusable, high-quality,
+-- peer-reviewed VHDL building blocks.
+-- https://hdl-modules.com
+-- https://github.com/hdl-modules/hdl-modules
+-- -------------------------------------------------------------------------------------------------
+-- Test the throughput of the core with address pipelining, against an AXI slave that never stalls.
+-- The data content is checked by the other testbenches.
+-- -------------------------------------------------------------------------------------------------
+
+library ieee;
+use ieee.numeric_std.all;
+use ieee.std_logic_1164.all;
+
+library osvvm;
+use osvvm.RandomPkg.RandomPType;
+
+library vunit_lib;
+use vunit_lib.check_pkg.all;
+use vunit_lib.queue_pkg.all;
+use vunit_lib.run_pkg.all;
+
+library axi;
+use axi.axi_pkg.all;
+
+library register_file;
+use register_file.register_file_pkg.all;
+
+use work.dma_axi_write_simple_register_record_pkg.all;
+
+
+entity tb_dma_axi_write_simple_throughput is
+  generic (
+    seed : natural;
+    runner_cfg : string
+  );
+end entity;
+
+architecture tb of tb_dma_axi_write_simple_throughput is
+
+  -- ---------------------------------------------------------------------------
+  -- Generic constants.
+  shared variable rnd : RandomPType;
+  impure function initialize_and_get_data_width return positive is
+  begin
+    rnd.InitSeed(seed);
+    -- Between 32 and 128 bits.
+    return 8 * 2 ** rnd.Uniform(2, 4);
+  end function;
+  -- Same width on both sides, so that the 'stream' maps directly to the AXI 'W' channel.
+  constant data_width : positive := initialize_and_get_data_width;
+  constant bytes_per_beat : positive := data_width / 8;
+
+  impure function get_enable_axi3 return boolean is
+  begin
+    return rnd.RandBool;
+  end function;
+  constant enable_axi3 : boolean := get_enable_axi3;
+
+  constant max_burst_length_beats : positive := get_max_burst_length_beats(
+    enable_axi3=>enable_axi3
+  );
+
+  impure function get_packet_length_beats return positive is
+  begin
+    if rnd.Uniform(1, 4) = 4 then
+      -- Long packets that will trigger burst splitting.
+      return 2 ** rnd.FavorSmall(0, 2) * max_burst_length_beats;
+    end if;
+
+    -- At least two beats, since a packet length of one AXI beat uses an implementation without
+    -- address pipelining.
+    return 2 ** rnd.Uniform(1, 4);
+  end function;
+  constant packet_length_beats : positive := get_packet_length_beats;
+  constant packet_length_bytes : positive := packet_length_beats * bytes_per_beat;
+
+  constant axi_id : natural := 0;
+  constant writeback_axi_id : natural := 1;
+
+  -- ---------------------------------------------------------------------------
+  -- DUT connections.
+  constant clk_period : time := 10 ns;
+  signal clk : std_ulogic := '0';
+
+  signal stream_ready, stream_valid : std_ulogic := '0';
+  signal stream_data : std_ulogic_vector(data_width - 1 downto 0) := (others => '0');
+
+  signal regs_up : dma_axi_write_simple_regs_up_t := dma_axi_write_simple_regs_up_init;
+  signal regs_down : dma_axi_write_simple_regs_down_t := dma_axi_write_simple_regs_down_init;
+
+  signal axi_m2s : axi_write_m2s_t := axi_write_m2s_init;
+  signal axi_s2m : axi_write_s2m_t := axi_write_s2m_init;
+
+  -- ---------------------------------------------------------------------------
+  -- Testbench stuff.
+  signal num_stream_beats : natural := 0;
+  signal start_stream : boolean := false;
+
+  -- Place the data buffer after the writeback location, and aligned with the packet length.
+  constant buffer_start_address : positive := packet_length_bytes;
+  constant writeback_address : natural := 0;
+
+  function to_register(value : natural) return register_t is
+  begin
+    return std_ulogic_vector(to_unsigned(value, register_width));
+  end function;
+
+begin
+
+  test_runner_watchdog(runner, 2 ms);
+  clk <= not clk after clk_period / 2;
+
+
+  ------------------------------------------------------------------------------
+  main : process
+
+    procedure setup_buffer(num_packets : positive) is
+    begin
+      regs_down.buffer_start_address <= to_register(buffer_start_address);
+      regs_down.buffer_end_address <= to_register(
+        buffer_start_address + num_packets * packet_length_bytes
+      );
+      regs_down.buffer_read_address <= to_register(buffer_start_address);
+    end procedure;
+
+    -- With address pipelining, and 'AWREADY' and 'WREADY' held high, there shall be no
+    -- per-burst overhead.
+    -- Meaning that once the first beat has been accepted, the 'stream' shall never stall.
+    -- The buffer fits all the data, so it will never be full.
+    procedure run_no_stall_test is
+      constant num_packets : positive := rnd.Uniform(8, 16);
+      constant num_beats : positive := num_packets * packet_length_beats;
+
+      variable num_beats_accepted : natural := 0;
+    begin
+      -- The DUT never fills the last packet of the buffer.
+      setup_buffer(num_packets=>num_packets + 1);
+      regs_down.config.enable <= '1';
+
+      num_stream_beats <= num_beats;
+      start_stream <= true;
+
+      wait until (stream_ready and stream_valid) = '1' and rising_edge(clk);
+      num_beats_accepted := 1;
+
+      while num_beats_accepted < num_beats loop
+        wait until rising_edge(clk);
+
+        check_equal(
+          stream_ready,
+          '1',
+          "Stream stall after " & to_string(num_beats_accepted) & " accepted beats"
+        );
+
+        if (stream_ready and stream_valid) = '1' then
+          num_beats_accepted := num_beats_accepted + 1;
+        end if;
+      end loop;
+
+      wait until
+        regs_up.buffer_written_address = to_register(
+          buffer_start_address + num_packets * packet_length_bytes
+        )
+        for 100 * packet_length_beats * clk_period;
+      check_equal(
+        unsigned(regs_up.buffer_written_address),
+        buffer_start_address + num_packets * packet_length_bytes,
+        "buffer_written_address"
+      );
+    end procedure;
+
+    -- A buffer of the minimum size, where the space is released by software with a varying delay.
+    -- Optionally with the written address writeback, which holds back data bursts.
+    -- The stream will stall since the buffer is full most of the time, but all data shall be
+    -- written eventually.
+    -- If the core lost track of a pipelined address transaction, it would hang, which would be
+    -- caught by the watchdog.
+    procedure run_minimum_buffer_test is
+      constant num_buffer_packets : positive := 2;
+      constant buffer_size_bytes : positive := num_buffer_packets * packet_length_bytes;
+      constant buffer_end_address : positive := buffer_start_address + buffer_size_bytes;
+
+      constant num_packets : positive := rnd.Uniform(8, 16);
+
+      variable written_address, read_address : natural := buffer_start_address;
+      variable num_bytes_received : natural := 0;
+    begin
+      setup_buffer(num_packets=>num_buffer_packets);
+
+      if rnd.RandBool then
+        report "Enabling writeback";
+        regs_down.writeback_address <= to_register(writeback_address);
+        regs_down.writeback_config.enable <= '1';
+      end if;
+
+      regs_down.config.enable <= '1';
+
+      num_stream_beats <= num_packets * packet_length_beats;
+      start_stream <= true;
+
+      while num_bytes_received < num_packets * packet_length_bytes loop
+        wait until rising_edge(clk);
+
+        written_address := to_integer(unsigned(regs_up.buffer_written_address));
+
+        if written_address /= read_address then
+          for delay_cycle in 1 to rnd.Uniform(0, 8) loop
+            wait until rising_edge(clk);
+          end loop;
+
+          if written_address > read_address then
+            num_bytes_received := num_bytes_received + written_address - read_address;
+          else
+            num_bytes_received := (
+              num_bytes_received + written_address + buffer_size_bytes - read_address
+            );
+          end if;
+
+          read_address := written_address;
+          if read_address = buffer_end_address then
+            read_address := buffer_start_address;
+          end if;
+
+          regs_down.buffer_read_address <= to_register(read_address);
+        end if;
+      end loop;
+
+      check_equal(num_bytes_received, num_packets * packet_length_bytes, "num_bytes_received");
+    end procedure;
+
+  begin
+    test_runner_setup(runner, runner_cfg);
+
+    report "data_width = " & to_string(data_width);
+    report "enable_axi3 = " & to_string(enable_axi3);
+    report "packet_length_beats = " & to_string(packet_length_beats);
+
+    if run("test_no_stall_with_address_pipelining") then
+      run_no_stall_test;
+
+    elsif run("test_minimum_buffer") then
+      run_minimum_buffer_test;
+    end if;
+
+    test_runner_cleanup(runner);
+  end process;
+
+
+  ------------------------------------------------------------------------------
+  -- Continuous data, without any stall.
+  stream_master : process
+    variable beat_idx : natural := 0;
+  begin
+    wait until start_stream and rising_edge(clk);
+
+    stream_valid <= '1';
+
+    while beat_idx < num_stream_beats loop
+      stream_data <= std_ulogic_vector(to_unsigned(beat_idx mod 2 ** 16, stream_data'length));
+
+      wait until (stream_ready and stream_valid) = '1' and rising_edge(clk);
+      beat_idx := beat_idx + 1;
+    end loop;
+
+    stream_valid <= '0';
+    wait;
+  end process;
+
+
+  ------------------------------------------------------------------------------
+  -- AXI slave that never stalls 'AW' or 'W'.
+  -- A 'B' response is sent once both the 'AW' transaction and the 'W' data of a burst have been
+  -- seen, since the DUT might send 'W' data before the address.
+  axi_slave : block
+    constant aw_id_queue : queue_t := new_queue;
+    signal num_w_bursts_done : natural := 0;
+  begin
+
+    axi_s2m.aw.ready <= '1';
+    axi_s2m.w.ready <= '1';
+
+
+    ------------------------------------------------------------------------------
+    handle_aw : process
+    begin
+      wait until (axi_s2m.aw.ready and axi_m2s.aw.valid) = '1' and rising_edge(clk);
+
+      push_integer(aw_id_queue, to_integer(axi_m2s.aw.id));
+    end process;
+
+
+    ------------------------------------------------------------------------------
+    handle_w : process
+    begin
+      wait until
+        (axi_s2m.w.ready and axi_m2s.w.valid and axi_m2s.w.last) = '1' and rising_edge(clk);
+
+      num_w_bursts_done <= num_w_bursts_done + 1;
+    end process;
+
+
+    ------------------------------------------------------------------------------
+    handle_b : process
+      variable num_b_sent : natural := 0;
+    begin
+      wait until rising_edge(clk);
+
+      if num_w_bursts_done > num_b_sent and not is_empty(aw_id_queue) then
+        axi_s2m.b.valid <= '1';
+        axi_s2m.b.id <= to_unsigned(pop_integer(aw_id_queue), axi_s2m.b.id'length);
+        axi_s2m.b.resp <= axi_resp_okay;
+
+        wait until (axi_m2s.b.ready and axi_s2m.b.valid) = '1' and rising_edge(clk);
+        axi_s2m.b.valid <= '0';
+        num_b_sent := num_b_sent + 1;
+      end if;
+    end process;
+
+  end block;
+
+
+  ------------------------------------------------------------------------------
+  dut : entity work.dma_axi_write_simple
+    generic map (
+      address_width => 32,
+      stream_data_width => data_width,
+      axi_data_width => data_width,
+      packet_length_beats => packet_length_beats,
+      enable_axi3 => enable_axi3,
+      enable_telemetry => false,
+      enable_flush_timeout => false,
+      enable_interrupt_coalescing => false,
+      enable_address_pipelining => true,
+      max_outstanding_bursts => 0,
+      axi_id => axi_id,
+      -- Present, but only enabled at runtime by one of the tests.
+      enable_written_address_writeback => true,
+      writeback_axi_id => writeback_axi_id,
+      enable_packet_metadata => false,
+      packet_metadata_fifo_depth => 64
+    )
+    port map (
+      clk => clk,
+      --
+      stream_ready => stream_ready,
+      stream_valid => stream_valid,
+      stream_data => stream_data,
+      --
+      regs_up => regs_up,
+      regs_down => regs_down,
+      interrupt => open,
+      --
+      axi_write_m2s => axi_m2s,
+      axi_write_s2m => axi_s2m
+    );
+
+end architecture;